@@ -2,6 +2,10 @@ QT       += core gui
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
+# QWidget::screen() and the high DPI rounding policy in main.cpp need 5.14.
+lessThan(QT_MAJOR_VERSION, 5): error("Qt 5.14 or later is required")
+equals(QT_MAJOR_VERSION, 5):lessThan(QT_MINOR_VERSION, 14): error("Qt 5.14 or later is required")
+
 CONFIG += c++11
 
 # The following define makes your compiler emit warnings if you use
@@ -20,13 +24,37 @@ SOURCES += \
     mainwindow.cpp \
     GameArea.cpp \
     GameAreaWinWidget.cpp \
-    GameAreaEndWidget.cpp
+    GameAreaEndWidget.cpp \
+    ReplayScrubber.cpp \
+    AutoSaver.cpp \
+    GameEngine.cpp \
+    GameAI.cpp \
+    GridEngine.cpp \
+    NTupleNetwork.cpp \
+    ReplayJournal.cpp \
+    SaveFile.cpp \
+    TableFile.cpp \
+    ThreadPool.cpp \
+    TurboPlayer.cpp \
+    UndoHistory.cpp
 
 HEADERS += \
     mainwindow.h \
     GameArea.h  \
     GameAreaWinWidget.h \
-    GameAreaEndWidget.h
+    GameAreaEndWidget.h \
+    ReplayScrubber.h \
+    AutoSaver.h \
+    GameEngine.h \
+    GameAI.h \
+    GridEngine.h \
+    NTupleNetwork.h \
+    ReplayJournal.h \
+    SaveFile.h \
+    TableFile.h \
+    ThreadPool.h \
+    TurboPlayer.h \
+    UndoHistory.h
 
 # Default rules for deployment.
 qnx: target.path = /tmp/$${TARGET}/bin
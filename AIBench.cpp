@@ -0,0 +1,73 @@
+//
+// Created by Rache on 2026/10/17.
+//
+// Measures the speedup of the multithreaded expectimax search on a fixed
+// set of positions and checks it against the single-threaded search.
+//
+// usage: 2048AIBench [depth] [max_threads]
+//
+
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <chrono>
+#include <vector>
+
+#include "GameAI.h"
+
+// Positions from one seeded game, so every run searches the same boards.
+static std::vector<Board> bench_positions() {
+    std::vector<Board> positions;
+    GameEngine game(2048);
+    GameAI ai(3);
+    game.new_game();
+    for (int moves = 1; positions.size() < 12; ++moves) {
+        SearchResult result = ai.search(game.board);
+        if (!result.found) break;
+        game.move(result.move);
+        if (moves % 100 == 0) positions.push_back(game.board);
+    }
+    return positions;
+}
+
+int main(int argc, char *argv[]) {
+    int depth = argc > 1 ? atoi(argv[1]) : 5;
+    int maxThreads = argc > 2 ? atoi(argv[2]) : ThreadPool::hardware_threads();
+    const double tolerance = 1e-4;
+
+    std::vector<Board> positions = bench_positions();
+    printf("%d positions, depth %d\n\n", (int)positions.size(), depth);
+    printf("%8s %10s %8s %12s %14s %6s\n", "threads", "time(ms)", "speedup", "Mnodes/s", "max rel diff", "moves");
+
+    std::vector<int> threadCounts;
+    for (int threads = 1; threads < maxThreads; threads *= 2) threadCounts.push_back(threads);
+    threadCounts.push_back(maxThreads);
+
+    std::vector<SearchResult> reference;
+    double baseTime = 0;
+    for (int threads : threadCounts) {
+        GameAI ai(depth, threads);
+        std::vector<SearchResult> results;
+        uint64_t nodes = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (Board b : positions) {
+            results.push_back(ai.search(b));
+            nodes += results.back().nodes;
+        }
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        if (threads == 1) {
+            reference = results;
+            baseTime = ms;
+        }
+        double maxDiff = 0;
+        int sameMoves = 0;
+        for (size_t i = 0; i < results.size(); ++i) {
+            maxDiff = std::max(maxDiff, std::fabs(results[i].value - reference[i].value) / std::fabs(reference[i].value));
+            if (results[i].move == reference[i].move) sameMoves++;
+        }
+        printf("%8d %10.1f %8.2f %12.2f %14.2e %3d/%-3d%s\n", threads, ms, baseTime / ms, nodes / ms / 1000,
+               maxDiff, sameMoves, (int)results.size(), maxDiff > tolerance ? "  OUT OF TOLERANCE" : "");
+    }
+    return 0;
+}
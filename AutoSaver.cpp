@@ -0,0 +1,57 @@
+//
+// Created by Rache on 2026/10/17.
+//
+
+#include "AutoSaver.h"
+
+#include "TableFile.h"
+
+AutoSaver::AutoSaver(std::string path) : filePath(std::move(path)) {
+    worker = std::thread(&AutoSaver::worker_loop, this);
+}
+
+AutoSaver::~AutoSaver() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    worker.join();
+}
+
+void AutoSaver::submit(std::vector<uint8_t> snapshot) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending.swap(snapshot);
+        hasPending = true;
+    }
+    // The replaced snapshot is freed here, outside the lock.
+    wake.notify_one();
+}
+
+void AutoSaver::flush() {
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [this] { return !hasPending && !writing; });
+}
+
+void AutoSaver::worker_loop() {
+    std::vector<uint8_t> snapshot;
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        wake.wait(lock, [this] { return hasPending || stopping; });
+        if (!hasPending) break;
+        snapshot.swap(pending);
+        hasPending = false;
+        writing = true;
+        lock.unlock();
+
+        bool ok = replace_file(filePath, {{snapshot.data(), snapshot.size()}}, true);
+        failed = !ok;
+        writes++;
+
+        lock.lock();
+        writing = false;
+        if (!hasPending) idle.notify_all();
+    }
+    idle.notify_all();
+}
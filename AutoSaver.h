@@ -0,0 +1,54 @@
+//
+// Created by Rache on 2026/10/17.
+//
+
+#ifndef INC_2048GAME_AUTOSAVER_H
+#define INC_2048GAME_AUTOSAVER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Writes snapshots of a game to one file on a background thread, so the
+// caller never waits for the disk. submit() only moves the bytes into a
+// slot; a snapshot submitted while an older one is still waiting replaces
+// it, so a burst of moves costs one write. Every write goes to a temporary
+// file that is synced and then renamed over the old one, so after a crash
+// the file holds the last complete snapshot.
+class AutoSaver {
+public:
+    explicit AutoSaver(std::string path);
+    // Writes the waiting snapshot, if any, then stops.
+    ~AutoSaver();
+    AutoSaver(const AutoSaver &) = delete;
+    AutoSaver &operator=(const AutoSaver &) = delete;
+
+    const std::string &path() const { return filePath; }
+    void submit(std::vector<uint8_t> snapshot);
+    // Waits until every submitted snapshot is on disk.
+    void flush();
+    uint64_t write_count() const { return writes; }
+    bool last_write_failed() const { return failed; }
+
+private:
+    void worker_loop();
+
+    std::string filePath;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable idle;
+    std::vector<uint8_t> pending;       // guarded by mutex
+    bool hasPending = false;            // guarded by mutex
+    bool writing = false;               // guarded by mutex
+    bool stopping = false;              // guarded by mutex
+    std::atomic<uint64_t> writes{0};
+    std::atomic<bool> failed{false};
+    std::thread worker;
+};
+
+
+#endif //INC_2048GAME_AUTOSAVER_H
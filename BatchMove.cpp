@@ -0,0 +1,232 @@
+//
+// Created by Rache on 2026/10/17.
+//
+
+#include "BatchMove.h"
+
+#include <cstring>
+
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#define BATCH_MOVE_X86 1
+#include <immintrin.h>
+#endif
+
+// The vector kernels read RowTransition entries as 64-bit words: result
+// row in the low 16 bits, score in the high 32 bits, and left and right
+// tables back to back.
+static_assert(sizeof(RowTransition) == 8, "RowTransition must be one 64-bit word");
+static_assert(offsetof(RowTransition, score) == 4, "RowTransition::score must be the high half");
+static_assert(offsetof(RowTables, right) == sizeof(RowTransition) << 16, "row tables must be contiguous");
+
+typedef void (*BatchMoveKernel)(const Board *boards, const uint8_t *directions, uint8_t direction, size_t count,
+                                Board *out, uint32_t *scores, uint64_t *movedMask);
+
+// Directions 0 and 1 (up, down) work on the transposed board, 1 and 3
+// (down, right) use the right table.
+static inline bool is_vertical(uint8_t d) { return d < 2; }
+static inline bool is_rightward(uint8_t d) { return (d & 1) != 0; }
+
+// Boards [begin, count); the vector kernels finish their tails with it.
+static void scalar_range(const Board *boards, const uint8_t *directions, uint8_t direction, size_t begin, size_t count,
+                         Board *out, uint32_t *scores, uint64_t *movedMask) {
+    const RowTables &tables = row_tables();
+    for (size_t i = begin; i < count; ++i) {
+        uint8_t d = directions ? directions[i] : direction;
+        Board b = boards[i];
+        Board src = is_vertical(d) ? board_transpose(b) : b;
+        const RowTransition *table = is_rightward(d) ? tables.right : tables.left;
+
+        const RowTransition &r0 = table[(Row)src];
+        const RowTransition &r1 = table[(Row)(src >> 16)];
+        const RowTransition &r2 = table[(Row)(src >> 32)];
+        const RowTransition &r3 = table[(Row)(src >> 48)];
+        Board result = (Board)r0.result | ((Board)r1.result << 16) | ((Board)r2.result << 32) | ((Board)r3.result << 48);
+        if (is_vertical(d)) result = board_transpose(result);
+
+        out[i] = result;
+        scores[i] = r0.score + r1.score + r2.score + r3.score;
+        if (result != b) movedMask[i >> 6] |= 1ULL << (i & 63);
+    }
+}
+
+static void scalar_kernel(const Board *boards, const uint8_t *directions, uint8_t direction, size_t count,
+                          Board *out, uint32_t *scores, uint64_t *movedMask) {
+    scalar_range(boards, directions, direction, 0, count, out, scores, movedMask);
+}
+
+#ifdef BATCH_MOVE_X86
+
+__attribute__((target("sse4.1")))
+static inline __m128i transpose_sse(__m128i b) {
+    __m128i a1 = _mm_and_si128(b, _mm_set1_epi64x((long long)0xF0F00F0FF0F00F0FULL));
+    __m128i a2 = _mm_and_si128(b, _mm_set1_epi64x((long long)0x0000F0F00000F0F0ULL));
+    __m128i a3 = _mm_and_si128(b, _mm_set1_epi64x((long long)0x0F0F00000F0F0000ULL));
+    __m128i a = _mm_or_si128(a1, _mm_or_si128(_mm_slli_epi64(a2, 12), _mm_srli_epi64(a3, 12)));
+    __m128i b1 = _mm_and_si128(a, _mm_set1_epi64x((long long)0xFF00FF0000FF00FFULL));
+    __m128i b2 = _mm_and_si128(a, _mm_set1_epi64x((long long)0x00FF00FF00000000ULL));
+    __m128i b3 = _mm_and_si128(a, _mm_set1_epi64x((long long)0x00000000FF00FF00ULL));
+    return _mm_or_si128(b1, _mm_or_si128(_mm_srli_epi64(b2, 24), _mm_slli_epi64(b3, 24)));
+}
+
+// SSE4.1 has no gather, so only the transposes and compares are vector
+// code; two boards are handled per step.
+__attribute__((target("sse4.1")))
+static void sse41_kernel(const Board *boards, const uint8_t *directions, uint8_t direction, size_t count,
+                         Board *out, uint32_t *scores, uint64_t *movedMask) {
+    const RowTables &tables = row_tables();
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        uint8_t d0 = directions ? directions[i] : direction;
+        uint8_t d1 = directions ? directions[i + 1] : direction;
+        __m128i b = _mm_loadu_si128((const __m128i *)(boards + i));
+        __m128i vertical = _mm_set_epi64x(is_vertical(d1) ? -1 : 0, is_vertical(d0) ? -1 : 0);
+        __m128i src = _mm_blendv_epi8(b, transpose_sse(b), vertical);
+
+        Board s[2] = {(Board)_mm_cvtsi128_si64(src), (Board)_mm_extract_epi64(src, 1)};
+        const RowTransition *table[2] = {is_rightward(d0) ? tables.right : tables.left,
+                                         is_rightward(d1) ? tables.right : tables.left};
+        Board r[2];
+        for (int k = 0; k < 2; ++k) {
+            const RowTransition &r0 = table[k][(Row)s[k]];
+            const RowTransition &r1 = table[k][(Row)(s[k] >> 16)];
+            const RowTransition &r2 = table[k][(Row)(s[k] >> 32)];
+            const RowTransition &r3 = table[k][(Row)(s[k] >> 48)];
+            r[k] = (Board)r0.result | ((Board)r1.result << 16) | ((Board)r2.result << 32) | ((Board)r3.result << 48);
+            scores[i + k] = r0.score + r1.score + r2.score + r3.score;
+        }
+
+        __m128i result = _mm_set_epi64x((long long)r[1], (long long)r[0]);
+        result = _mm_blendv_epi8(result, transpose_sse(result), vertical);
+        int same = _mm_movemask_pd(_mm_castsi128_pd(_mm_cmpeq_epi64(result, b)));
+        _mm_storeu_si128((__m128i *)(out + i), result);
+        movedMask[i >> 6] |= (uint64_t)(same ^ 0x3) << (i & 63);
+    }
+    scalar_range(boards, directions, direction, i, count, out, scores, movedMask);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i transpose_avx2(__m256i b) {
+    __m256i a1 = _mm256_and_si256(b, _mm256_set1_epi64x((long long)0xF0F00F0FF0F00F0FULL));
+    __m256i a2 = _mm256_and_si256(b, _mm256_set1_epi64x((long long)0x0000F0F00000F0F0ULL));
+    __m256i a3 = _mm256_and_si256(b, _mm256_set1_epi64x((long long)0x0F0F00000F0F0000ULL));
+    __m256i a = _mm256_or_si256(a1, _mm256_or_si256(_mm256_slli_epi64(a2, 12), _mm256_srli_epi64(a3, 12)));
+    __m256i b1 = _mm256_and_si256(a, _mm256_set1_epi64x((long long)0xFF00FF0000FF00FFULL));
+    __m256i b2 = _mm256_and_si256(a, _mm256_set1_epi64x((long long)0x00FF00FF00000000ULL));
+    __m256i b3 = _mm256_and_si256(a, _mm256_set1_epi64x((long long)0x00000000FF00FF00ULL));
+    return _mm256_or_si256(b1, _mm256_or_si256(_mm256_srli_epi64(b2, 24), _mm256_slli_epi64(b3, 24)));
+}
+
+// Four boards per step: every row of every board is looked up with one
+// 64-bit gather per row position.
+__attribute__((target("avx2")))
+static void avx2_kernel(const Board *boards, const uint8_t *directions, uint8_t direction, size_t count,
+                        Board *out, uint32_t *scores, uint64_t *movedMask) {
+    const auto *table = (const long long *)row_tables().left;
+    const __m256i rowMask = _mm256_set1_epi64x(0xffff);
+    const __m256i resultMask = _mm256_set1_epi64x(0xffff);
+    const __m256i one = _mm256_set1_epi64x(1);
+    const __m256i two = _mm256_set1_epi64x(2);
+    const __m256i evenLanes = _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6);
+    const __m256i uniform = _mm256_set1_epi64x(direction);
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256i d = uniform;
+        if (directions) {
+            int32_t packed;
+            memcpy(&packed, directions + i, sizeof(packed));
+            d = _mm256_cvtepu8_epi64(_mm_cvtsi32_si128(packed));
+        }
+        __m256i vertical = _mm256_cmpgt_epi64(two, d);
+        __m256i tableOffset = _mm256_slli_epi64(_mm256_and_si256(d, one), 16);
+
+        __m256i b = _mm256_loadu_si256((const __m256i *)(boards + i));
+        __m256i src = _mm256_blendv_epi8(b, transpose_avx2(b), vertical);
+
+        __m256i result = _mm256_setzero_si256();
+        __m256i score = _mm256_setzero_si256();
+        for (int r = 0; r < BOARD_SIZE; ++r) {
+            __m256i shift = _mm256_set1_epi64x(16 * r);
+            __m256i index = _mm256_add_epi64(_mm256_and_si256(_mm256_srlv_epi64(src, shift), rowMask), tableOffset);
+            __m128i index32 = _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(index, evenLanes));
+            __m256i entry = _mm256_i32gather_epi64(table, index32, 8);
+            result = _mm256_or_si256(result, _mm256_sllv_epi64(_mm256_and_si256(entry, resultMask), shift));
+            score = _mm256_add_epi64(score, _mm256_srli_epi64(entry, 32));
+        }
+        result = _mm256_blendv_epi8(result, transpose_avx2(result), vertical);
+
+        int same = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(result, b)));
+        _mm256_storeu_si256((__m256i *)(out + i), result);
+        _mm_storeu_si128((__m128i *)(scores + i), _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(score, evenLanes)));
+        // i is a multiple of 4, so the four bits never straddle two words.
+        movedMask[i >> 6] |= (uint64_t)(same ^ 0xf) << (i & 63);
+    }
+    scalar_range(boards, directions, direction, i, count, out, scores, movedMask);
+}
+
+#endif
+
+static bool kernel_supported(BatchKernel kernel) {
+    switch (kernel) {
+        case BatchKernel::Scalar:
+            return true;
+#ifdef BATCH_MOVE_X86
+        case BatchKernel::SSE41:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("sse4.1");
+        case BatchKernel::AVX2:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2");
+#endif
+        default:
+            return false;
+    }
+}
+
+static BatchKernel best_kernel(BatchKernel limit) {
+    for (int k = (int)limit; k > 0; --k) {
+        if (kernel_supported((BatchKernel)k)) return (BatchKernel)k;
+    }
+    return BatchKernel::Scalar;
+}
+
+static BatchKernel activeKernel = best_kernel(BatchKernel::AVX2);
+
+static BatchMoveKernel kernel_function(BatchKernel kernel) {
+    switch (kernel) {
+#ifdef BATCH_MOVE_X86
+        case BatchKernel::SSE41: return sse41_kernel;
+        case BatchKernel::AVX2:  return avx2_kernel;
+#endif
+        default:                 return scalar_kernel;
+    }
+}
+
+BatchKernel batch_move_kernel() {
+    return activeKernel;
+}
+
+void set_batch_move_kernel(BatchKernel kernel) {
+    activeKernel = best_kernel(kernel);
+}
+
+const char *batch_kernel_name(BatchKernel kernel) {
+    switch (kernel) {
+        case BatchKernel::Scalar: return "scalar";
+        case BatchKernel::SSE41:  return "sse4.1";
+        case BatchKernel::AVX2:   return "avx2";
+    }
+    return "";
+}
+
+void batch_move(const Board *boards, const uint8_t *directions, size_t count,
+                Board *out, uint32_t *scores, uint64_t *movedMask) {
+    memset(movedMask, 0, (count + 63) / 64 * sizeof(uint64_t));
+    kernel_function(activeKernel)(boards, directions, 0, count, out, scores, movedMask);
+}
+
+void batch_move(const Board *boards, Direction d, size_t count,
+                Board *out, uint32_t *scores, uint64_t *movedMask) {
+    memset(movedMask, 0, (count + 63) / 64 * sizeof(uint64_t));
+    kernel_function(activeKernel)(boards, nullptr, (uint8_t)d, count, out, scores, movedMask);
+}
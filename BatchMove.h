@@ -0,0 +1,40 @@
+//
+// Created by Rache on 2026/10/17.
+//
+
+#ifndef INC_2048GAME_BATCHMOVE_H
+#define INC_2048GAME_BATCHMOVE_H
+
+#include <cstddef>
+#include "GameEngine.h"
+
+// Applies one move to each of `count` boards at once, for stepping many
+// independent games in lockstep. The outputs are separate arrays:
+//   out[i]        the board after the move (may alias boards)
+//   scores[i]     points gained by the move
+//   movedMask     bit i % 64 of word i / 64 is set when board i changed;
+//                 it needs (count + 63) / 64 words
+// directions[i] is the Direction of board i; the overload without it moves
+// every board the same way. Each step always fills every output.
+//
+// The kernel is picked once at runtime: AVX2 (table lookups with gathers),
+// SSE4.1 (vector transposes, scalar lookups) or plain scalar code.
+void batch_move(const Board *boards, const uint8_t *directions, size_t count,
+                Board *out, uint32_t *scores, uint64_t *movedMask);
+void batch_move(const Board *boards, Direction d, size_t count,
+                Board *out, uint32_t *scores, uint64_t *movedMask);
+
+enum class BatchKernel : int {
+    Scalar = 0,
+    SSE41 = 1,
+    AVX2 = 2
+};
+
+BatchKernel batch_move_kernel();
+// Forces a kernel, e.g. to compare them; falls back to the best supported
+// one when the CPU lacks the requested instructions.
+void set_batch_move_kernel(BatchKernel kernel);
+const char *batch_kernel_name(BatchKernel kernel);
+
+
+#endif //INC_2048GAME_BATCHMOVE_H
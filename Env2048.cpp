@@ -0,0 +1,112 @@
+//
+// Created by Rache on 2026/10/17.
+//
+
+#include "Env2048.h"
+
+#include <vector>
+#include "BatchMove.h"
+
+struct Env2048 {
+    explicit Env2048(int n)
+            : count(n), boards(n), highs(n), scores(n), randoms(n), done(n),
+              moved(n), gained(n), movedMask((n + 63) / 64) {}
+
+    int count;
+    std::vector<Board> boards;
+    std::vector<Board> highs;       // WideBoard::high of each board
+    std::vector<int64_t> scores;
+    std::vector<GameRandom> randoms;
+    std::vector<uint8_t> done;
+
+    // Scratch for batch_move, sized once so steps never allocate.
+    std::vector<Board> moved;
+    std::vector<uint32_t> gained;
+    std::vector<uint64_t> movedMask;
+};
+
+static void new_game(Env2048 *env, int i) {
+    env->boards[i] = board_spawn(board_spawn(0, env->randoms[i]), env->randoms[i]);
+    env->highs[i] = 0;
+    env->scores[i] = 0;
+    env->done[i] = 0;
+}
+
+// batch_move keeps two 32768s apart, so boards holding one move here.
+static void wide_step(Env2048 *env, int i, Direction d, float *reward) {
+    WideBoard b{env->boards[i], env->highs[i]};
+    int64_t gained = 0;
+    WideBoard next = wide_move(b, d, &gained);
+    if (next == b) return;
+    next = wide_spawn(next, env->randoms[i]);
+    env->boards[i] = next.low;
+    env->highs[i] = next.high;
+    env->scores[i] += gained;
+    *reward = (float)gained;
+}
+
+Env2048 *env2048_create(int count) {
+    if (count <= 0) return nullptr;
+    return new Env2048(count);
+}
+
+void env2048_destroy(Env2048 *env) {
+    delete env;
+}
+
+int env2048_count(const Env2048 *env) {
+    return env->count;
+}
+
+void env2048_reset(Env2048 *env, const uint64_t *seeds, uint64_t *boards, uint8_t *legalMask) {
+    for (int i = 0; i < env->count; ++i) {
+        if (seeds) env->randoms[i].seed(seeds[i]);
+        new_game(env, i);
+        boards[i] = env->boards[i];
+        legalMask[i] = (uint8_t)board_legal_moves(env->boards[i]);
+    }
+}
+
+void env2048_step(Env2048 *env, const uint8_t *actions, uint64_t *boards, float *rewards, uint8_t *done, uint8_t *legalMask) {
+    batch_move(env->boards.data(), actions, env->count, env->moved.data(), env->gained.data(), env->movedMask.data());
+
+    for (int i = 0; i < env->count; ++i) {
+        rewards[i] = 0;
+        if (env->done[i]) {
+            new_game(env, i);
+        } else if (actions[i] < 4 && (env->highs[i] != 0 || board_holds_max_tile(env->boards[i]))) {
+            wide_step(env, i, (Direction)actions[i], &rewards[i]);
+        } else if (actions[i] < 4 && (env->movedMask[i >> 6] >> (i & 63) & 1)) {
+            env->boards[i] = board_spawn(env->moved[i], env->randoms[i]);
+            env->scores[i] += env->gained[i];
+            rewards[i] = (float)env->gained[i];
+        }
+
+        int legal = wide_legal_moves({env->boards[i], env->highs[i]});
+        env->done[i] = legal == 0;
+        boards[i] = env->boards[i];
+        done[i] = env->done[i];
+        legalMask[i] = (uint8_t)legal;
+    }
+}
+
+void env2048_scores(const Env2048 *env, int64_t *scores) {
+    for (int i = 0; i < env->count; ++i) scores[i] = env->scores[i];
+}
+
+void env2048_highs(const Env2048 *env, uint64_t *highs) {
+    for (int i = 0; i < env->count; ++i) highs[i] = env->highs[i];
+}
+
+void env2048_decode(const uint64_t *boards, int count, uint8_t *cells) {
+    for (int i = 0; i < count; ++i) {
+        Board b = boards[i];
+        for (int c = 0; c < CELL_COUNT; ++c, b >>= 4) *cells++ = (uint8_t)(b & 0xf);
+    }
+}
+
+void env2048_decode_wide(const uint64_t *boards, const uint64_t *highs, int count, uint8_t *cells) {
+    for (int i = 0; i < count; ++i) {
+        for (int c = 0; c < CELL_COUNT; ++c) *cells++ = (uint8_t)wide_get({boards[i], highs[i]}, c / BOARD_SIZE, c % BOARD_SIZE);
+    }
+}
@@ -0,0 +1,75 @@
+/*
+ * Created by Rache on 2026/10/17.
+ *
+ * C interface to N independent 2048 games stepped together, for training
+ * agents from Python (ctypes / cffi) or any other language with a C FFI.
+ *
+ * Every output is written into buffers owned by the caller, with one
+ * element per environment (legal masks: one byte per environment), and no
+ * call allocates after env2048_create. Boards are packed 64-bit values,
+ * one nibble per cell in row-major order holding the tile exponent
+ * (0 empty, 1 is 2, 2 is 4, ...); env2048_decode unpacks them.
+ *
+ * Tiles go on past 32768, the most a nibble holds. Such a tile's exponent
+ * is its nibble in the board plus 16 times its nibble in the board's high
+ * half, which env2048_highs returns; the high half is 0 until a game gets
+ * past 32768, and env2048_decode_wide unpacks both.
+ *
+ * Actions: 0 up, 1 down, 2 left, 3 right. Legal mask bit a is set when
+ * action a changes the board. Spawns and merges follow the game's rules.
+ *
+ * An environment whose step returns done = 1 has no legal action left.
+ * The next env2048_step starts a new game in it from its own random
+ * stream and reports the new board with reward 0 and done 0, whatever
+ * action was passed for it.
+ */
+
+#ifndef INC_2048GAME_ENV2048_H
+#define INC_2048GAME_ENV2048_H
+
+#include <stdint.h>
+
+#if defined(_WIN32)
+#define ENV2048_API __declspec(dllexport)
+#else
+#define ENV2048_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct Env2048 Env2048;
+
+ENV2048_API Env2048 *env2048_create(int count);
+ENV2048_API void env2048_destroy(Env2048 *env);
+ENV2048_API int env2048_count(const Env2048 *env);
+
+/* Starts a new game in every environment. Environment i is seeded with
+ * seeds[i], so the same seeds replay the same games; pass NULL to keep the
+ * current random streams. */
+ENV2048_API void env2048_reset(Env2048 *env, const uint64_t *seeds,
+                               uint64_t *boards, uint8_t *legalMask);
+
+/* An illegal action leaves the board unchanged with reward 0. Rewards are
+ * the points scored by the move. */
+ENV2048_API void env2048_step(Env2048 *env, const uint8_t *actions,
+                              uint64_t *boards, float *rewards, uint8_t *done, uint8_t *legalMask);
+
+/* Total score of each environment's current game. */
+ENV2048_API void env2048_scores(const Env2048 *env, int64_t *scores);
+
+/* High half of each environment's current board, as of the last reset or
+ * step. */
+ENV2048_API void env2048_highs(const Env2048 *env, uint64_t *highs);
+
+/* Unpacks count boards into count * 16 tile exponents. */
+ENV2048_API void env2048_decode(const uint64_t *boards, int count, uint8_t *cells);
+/* Same, with the high halves from env2048_highs. */
+ENV2048_API void env2048_decode_wide(const uint64_t *boards, const uint64_t *highs, int count, uint8_t *cells);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_2048GAME_ENV2048_H */
@@ -0,0 +1,311 @@
+//
+// Created by Rache on 2026/10/17.
+//
+
+#include "GameAI.h"
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+// Row heuristic weights: reward empty cells, pairs that can merge and
+// monotonic rows, penalize large tiles spread over the board.
+static const double LOST_PENALTY        = 200000.0;
+static const double MONOTONICITY_POWER  = 4.0;
+static const double MONOTONICITY_WEIGHT = 47.0;
+static const double SUM_POWER           = 3.5;
+static const double SUM_WEIGHT          = 11.0;
+static const double MERGES_WEIGHT       = 700.0;
+static const double EMPTY_WEIGHT        = 270.0;
+
+static float row_heuristic(Row row) {
+    int line[BOARD_SIZE];
+    for (int i = 0; i < BOARD_SIZE; ++i) line[i] = (row >> (4 * i)) & 0xf;
+
+    double sum = 0;
+    int empty = 0;
+    int merges = 0;
+    int prev = 0;
+    int counter = 0;
+    for (int n : line) {
+        sum += std::pow(n, SUM_POWER);
+        if (n == 0) {
+            empty++;
+        } else {
+            if (prev == n) {
+                counter++;
+            } else if (counter > 0) {
+                merges += 1 + counter;
+                counter = 0;
+            }
+            prev = n;
+        }
+    }
+    if (counter > 0) merges += 1 + counter;
+
+    double monotonicityLeft = 0;
+    double monotonicityRight = 0;
+    for (int i = 1; i < BOARD_SIZE; ++i) {
+        if (line[i - 1] > line[i]) {
+            monotonicityLeft += std::pow(line[i - 1], MONOTONICITY_POWER) - std::pow(line[i], MONOTONICITY_POWER);
+        } else {
+            monotonicityRight += std::pow(line[i], MONOTONICITY_POWER) - std::pow(line[i - 1], MONOTONICITY_POWER);
+        }
+    }
+
+    return (float)(LOST_PENALTY + EMPTY_WEIGHT * empty + MERGES_WEIGHT * merges
+                   - MONOTONICITY_WEIGHT * std::min(monotonicityLeft, monotonicityRight)
+                   - SUM_WEIGHT * sum);
+}
+
+static const float *heuristic_table() {
+    static const float *table = [] {
+        auto *t = new float[1 << 16];
+        for (int row = 0; row < (1 << 16); ++row) t[row] = row_heuristic((Row)row);
+        return t;
+    }();
+    return table;
+}
+
+TranspositionTable::TranspositionTable(int bits)
+        : entries(new Entry[(size_t)1 << bits]), mask(((uint64_t)1 << bits) - 1) {
+}
+
+void TranspositionTable::new_generation() {
+    // Generation 0 marks never-written entries.
+    if (++generation == 0) {
+        for (uint64_t i = 0; i <= mask; ++i) {
+            entries[i].check.store(0, std::memory_order_relaxed);
+            entries[i].data.store(0, std::memory_order_relaxed);
+        }
+        generation = 1;
+    }
+}
+
+bool TranspositionTable::probe(WideBoard b, int depth, double *value) const {
+    uint64_t k = key(b);
+    const Entry &entry = entries[hash(k) & mask];
+    uint64_t data = entry.data.load(std::memory_order_relaxed);
+    uint64_t check = entry.check.load(std::memory_order_relaxed);
+    if ((check ^ data) != k) return false;
+    if ((uint8_t)(data >> 40) != generation || (int)((data >> 32) & 0xff) < depth) return false;
+
+    auto bits = (uint32_t)data;
+    float v;
+    memcpy(&v, &bits, sizeof(v));
+    *value = v;
+    return true;
+}
+
+void TranspositionTable::store(WideBoard b, int depth, double value) {
+    uint64_t k = key(b);
+    Entry &entry = entries[hash(k) & mask];
+    auto v = (float)value;
+    uint32_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    uint64_t data = bits | ((uint64_t)(uint8_t)depth << 32) | ((uint64_t)generation << 40);
+    entry.data.store(data, std::memory_order_relaxed);
+    entry.check.store(k ^ data, std::memory_order_relaxed);
+}
+
+GameAI::GameAI(int d, int t) : depth(d), threads(t) {
+}
+
+double GameAI::evaluate(Board b) {
+    const float *table = heuristic_table();
+    Board t = board_transpose(b);
+    return (double)table[(Row)b] + table[(Row)(b >> 16)] + table[(Row)(b >> 32)] + table[(Row)(b >> 48)]
+         + table[(Row)t] + table[(Row)(t >> 16)] + table[(Row)(t >> 32)] + table[(Row)(t >> 48)];
+}
+
+SearchResult GameAI::search(WideBoard b) {
+    auto start = Clock::now();
+    table.new_generation();
+    hasDeadline = false;
+    aborted = false;
+
+    SearchResult result = search_depth(b, depth);
+    result.elapsedMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    return result;
+}
+
+SearchResult GameAI::search_timed(WideBoard b, double budgetMs) {
+    auto start = Clock::now();
+    table.new_generation();
+    aborted = false;
+
+    // Depth 1 is a handful of evaluations; run it without a deadline so
+    // there is always a move to return.
+    hasDeadline = false;
+    SearchResult best = search_depth(b, 1);
+    uint64_t nodes = best.nodes;
+
+    hasDeadline = true;
+    deadline = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(budgetMs));
+    for (int d = 2; d <= depth && best.found && Clock::now() < deadline; ++d) {
+        SearchResult result = search_depth(b, d);
+        nodes += result.nodes;
+        if (aborted) break;
+        best = result;
+    }
+    hasDeadline = false;
+
+    best.nodes = nodes;
+    best.elapsedMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    return best;
+}
+
+bool GameAI::out_of_time(uint64_t nodes) {
+    if (aborted.load(std::memory_order_relaxed)) return true;
+    if (!hasDeadline || (nodes & 0x3ff) != 0) return false;
+    if (Clock::now() < deadline) return false;
+    aborted = true;
+    return true;
+}
+
+// The search runs on a Board while no tile can merge past it, and on a
+// WideBoard from the first move that makes a MAX_TILE_EXPONENT on; these
+// overloads let one template serve both.
+static Board occupied(Board b) { return b; }
+static Board occupied(WideBoard b) { return b.low | b.high; }
+static Board with_tile(Board b, int cell, int number) { return b | (Board)number << (4 * cell); }
+static WideBoard with_tile(WideBoard b, int cell, int number) { return {b.low | (Board)number << (4 * cell), b.high}; }
+static Board moved(Board b, Direction d) { return board_move(b, d); }
+static WideBoard moved(WideBoard b, Direction d) { return wide_move(b, d); }
+static WideBoard widened(Board b) { return {b, 0}; }
+static WideBoard widened(WideBoard b) { return b; }
+
+SearchResult GameAI::search_depth(WideBoard b, int depth) {
+    if (b.high == 0 && !board_holds_max_tile(b.low)) return search_moves(b.low, depth);
+    return search_moves(b, depth);
+}
+
+template <typename B>
+SearchResult GameAI::search_moves(B b, int depth) {
+    if (threads > 1 && depth > 1) return search_parallel(b, depth);
+
+    SearchResult result;
+    result.depth = depth;
+    for (int d = 0; d < 4; ++d) {
+        B next = moved(b, (Direction)d);
+        if (next == b) continue;
+        double value = after_move(next, depth - 1, 1.0, result.nodes);
+        if (!result.found || value > result.value) {
+            result.found = true;
+            result.move = (Direction)d;
+            result.value = value;
+        }
+    }
+    return result;
+}
+
+template <typename B>
+SearchResult GameAI::search_parallel(B b, int depth) {
+    struct RootTask {
+        int direction;
+        WideBoard board;
+        double weight;
+        double value;
+        uint64_t nodes;
+    };
+
+    std::vector<RootTask> tasks;
+    for (int d = 0; d < 4; ++d) {
+        WideBoard next = widened(moved(b, (Direction)d));
+        if (next == widened(b)) continue;
+        int emptyCount = wide_empty_count(next);
+        Board t = occupied(next);
+        for (int i = 0; i < CELL_COUNT; ++i, t >>= 4) {
+            if ((t & 0xf) != 0) continue;
+            tasks.push_back({d, with_tile(next, i, 1), 0.9 / emptyCount, 0, 0});
+            tasks.push_back({d, with_tile(next, i, 2), 0.1 / emptyCount, 0, 0});
+        }
+    }
+
+    if (!pool || pool->size() != threads) pool.reset(new ThreadPool(threads));
+    std::atomic<size_t> nextTask(0);
+    for (int i = 0; i < threads; ++i) {
+        pool->submit([this, depth, &tasks, &nextTask] {
+            for (size_t k; (k = nextTask.fetch_add(1, std::memory_order_relaxed)) < tasks.size(); ) {
+                RootTask &task = tasks[k];
+                const WideBoard &board = task.board;
+                task.value = board.high == 0 && !board_holds_max_tile(board.low)
+                             ? max_node(board.low, depth - 1, task.weight, task.nodes)
+                             : max_node(board, depth - 1, task.weight, task.nodes);
+            }
+        });
+    }
+    pool->wait();
+
+    // Matches the sequential search up to rounding, and up to which thread
+    // filled a transposition table entry first.
+    SearchResult result;
+    result.depth = depth;
+    double values[4] = {0, 0, 0, 0};
+    bool legal[4] = {false, false, false, false};
+    for (const RootTask &task : tasks) {
+        values[task.direction] += task.weight * task.value;
+        legal[task.direction] = true;
+        result.nodes += task.nodes;
+    }
+    for (int d = 0; d < 4; ++d) {
+        if (!legal[d]) continue;
+        result.nodes++;
+        if (!result.found || values[d] > result.value) {
+            result.found = true;
+            result.move = (Direction)d;
+            result.value = values[d];
+        }
+    }
+    return result;
+}
+
+template <typename B>
+double GameAI::max_node(B b, int d, double probability, uint64_t &nodes) {
+    nodes++;
+    if (out_of_time(nodes)) return 0;
+    double best = 0;
+    for (int dir = 0; dir < 4; ++dir) {
+        B next = moved(b, (Direction)dir);
+        if (next == b) continue;
+        best = std::max(best, after_move(next, d - 1, probability, nodes));
+    }
+    return best;
+}
+
+// A move that makes a MAX_TILE_EXPONENT on a Board hands the subtree to the
+// WideBoard search, where it can merge with another one.
+double GameAI::after_move(Board next, int d, double probability, uint64_t &nodes) {
+    if (board_holds_max_tile(next)) return chance_node(WideBoard{next, 0}, d, probability, nodes);
+    return chance_node(next, d, probability, nodes);
+}
+
+double GameAI::after_move(WideBoard next, int d, double probability, uint64_t &nodes) {
+    return chance_node(next, d, probability, nodes);
+}
+
+template <typename B>
+double GameAI::chance_node(B b, int d, double probability, uint64_t &nodes) {
+    nodes++;
+    if (d <= 0 || probability < probabilityCutoff) return leaf_value(b);
+
+    double value;
+    if (table.probe(widened(b), d, &value)) return value;
+
+    Board t = occupied(b);
+    int emptyCount = board_empty_count(t);
+    if (emptyCount == 0) return leaf_value(b);
+    double cellProbability = probability / emptyCount;
+    double sum = 0;
+    for (int i = 0; i < CELL_COUNT; ++i, t >>= 4) {
+        if ((t & 0xf) != 0) continue;
+        sum += 0.9 * max_node(with_tile(b, i, 1), d, cellProbability * 0.9, nodes);
+        sum += 0.1 * max_node(with_tile(b, i, 2), d, cellProbability * 0.1, nodes);
+    }
+    value = sum / emptyCount;
+
+    // An abandoned subtree holds partial sums; keep them out of the table.
+    if (aborted.load(std::memory_order_relaxed)) return 0;
+    table.store(widened(b), d, value);
+    return value;
+}
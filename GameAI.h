@@ -0,0 +1,128 @@
+//
+// Created by Rache on 2026/10/17.
+//
+
+#ifndef INC_2048GAME_GAMEAI_H
+#define INC_2048GAME_GAMEAI_H
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include "GameEngine.h"
+#include "ThreadPool.h"
+
+struct SearchResult {
+    bool found = false;         // false when no move changes the board
+    Direction move = Direction::Up;
+    double value = 0;
+    int depth = 0;              // deepest completed iteration
+    uint64_t nodes = 0;
+    double elapsedMs = 0;
+};
+
+// Scores a board at the leaves of the search. Boards are afterstates: a
+// move has been made and the next tile has not spawned yet. Boards with a
+// tile past MAX_TILE_EXPONENT go to evaluate_wide, which by default scores
+// them capped.
+class BoardEvaluator {
+public:
+    virtual ~BoardEvaluator() = default;
+    virtual double evaluate(Board b) const = 0;
+    virtual double evaluate_wide(WideBoard b) const { return evaluate(wide_capped(b)); }
+};
+
+// Caches chance node values by board and is shared by all search threads
+// without locks. Each entry stores its key XORed with its data word, so an
+// entry torn by two threads writing at once fails the key check instead of
+// returning another board's value. Entries from earlier searches are told
+// apart by a generation number instead of clearing the table. The key of a
+// WideBoard is its low half XORed with a hash of the high one, so boards
+// with high = 0 are keyed by their Board.
+class TranspositionTable {
+public:
+    explicit TranspositionTable(int bits = 20);
+
+    void new_generation();
+    bool probe(WideBoard b, int depth, double *value) const;
+    void store(WideBoard b, int depth, double value);
+
+private:
+    struct Entry {
+        std::atomic<uint64_t> check{0};     // key ^ data
+        std::atomic<uint64_t> data{0};      // value bits | depth << 32 | generation << 40
+    };
+
+    static uint64_t hash(Board b) {
+        b ^= b >> 31;
+        b *= 0x7FB5D329728EA185ULL;
+        b ^= b >> 27;
+        return b;
+    }
+    static uint64_t key(WideBoard b) { return b.low ^ hash(b.high); }
+
+    std::unique_ptr<Entry[]> entries;
+    uint64_t mask;
+    uint8_t generation = 1;
+};
+
+// Expectimax over the four moves (max nodes) and the 90% / 10% spawns of a
+// 2 or a 4 on every empty cell (chance nodes). Branches whose probability
+// falls under probabilityCutoff are evaluated instead of expanded.
+//
+// With more than one thread the root is split into one task per move and
+// spawn (direction, cell, 2 or 4), which the threads pull from a shared
+// counter; all of them read and write the same transposition table.
+//
+// search_timed deepens one ply at a time from depth 1 up to `depth` and
+// returns the best move of the deepest iteration that finished within the
+// budget. The iteration running when the budget runs out is abandoned.
+//
+// The search runs on WideBoards, so tiles past MAX_TILE_EXPONENT merge in
+// the lookahead as in the game; a Board is searched as the WideBoard with
+// high = 0.
+class GameAI {
+public:
+    explicit GameAI(int depth = 3, int threads = 1);
+
+    SearchResult search(WideBoard b);
+    SearchResult search(Board b) { return search(WideBoard{b, 0}); }
+    SearchResult search_timed(WideBoard b, double budgetMs);
+    SearchResult search_timed(Board b, double budgetMs) { return search_timed(WideBoard{b, 0}, budgetMs); }
+    // The built-in row heuristic, used when no evaluator is set. Tiles past
+    // MAX_TILE_EXPONENT count as MAX_TILE_EXPONENT.
+    static double evaluate(Board b);
+
+    int depth;
+    int threads;
+    double probabilityCutoff = 0.0001;
+    // Not owned. Must stay valid while searches run.
+    const BoardEvaluator *evaluator = nullptr;
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    // B is Board or WideBoard, see GameAI.cpp.
+    SearchResult search_depth(WideBoard b, int depth);
+    template <typename B> SearchResult search_moves(B b, int depth);
+    template <typename B> SearchResult search_parallel(B b, int depth);
+    template <typename B> double max_node(B b, int depth, double probability, uint64_t &nodes);
+    template <typename B> double chance_node(B b, int depth, double probability, uint64_t &nodes);
+    double after_move(Board next, int depth, double probability, uint64_t &nodes);
+    double after_move(WideBoard next, int depth, double probability, uint64_t &nodes);
+    bool out_of_time(uint64_t nodes);
+    double leaf_value(Board b) const { return evaluator ? evaluator->evaluate(b) : evaluate(b); }
+    double leaf_value(WideBoard b) const {
+        if (b.high == 0) return leaf_value(b.low);
+        return evaluator ? evaluator->evaluate_wide(b) : evaluate(wide_capped(b));
+    }
+
+    TranspositionTable table;
+    std::unique_ptr<ThreadPool> pool;
+
+    bool hasDeadline = false;
+    Clock::time_point deadline;
+    std::atomic<bool> aborted{false};
+};
+
+
+#endif //INC_2048GAME_GAMEAI_H
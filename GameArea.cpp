@@ -5,30 +5,27 @@
 #include "GameArea.h"
 
 #include <QPainter>
+#include <QtMath>
 #include <QDebug>
 #include <iostream>
 #include <QPropertyAnimation>
 #include <QSequentialAnimationGroup>
 
 GameArea::GameArea() {
-    for (int i = 0; i < 4; ++i) {
-        for (int j = 0; j < 4; ++j) {
+    for (int i = 0; i < MAX_BOARD_SIZE; ++i) {
+        for (int j = 0; j < MAX_BOARD_SIZE; ++j) {
             cellRect[i][j] = QRect(frameSep + (cellSize + cellSep) * j,
                                    frameSep + (cellSize + cellSep) * i,
                                    cellSize, cellSize);
         }
     }
     memset(data, 0, sizeof(data));
+    memset(boardData, 0, sizeof(boardData));
 
     setFixedSize(frameSize, frameSize);
 
-    moveAnimationTimer.setInterval(6);
-    spawnAnimationTimer1.setInterval(1);
-    spawnAnimationTimer2.setInterval(1);
-
-    connect(&moveAnimationTimer, SIGNAL(timeout()), this, SLOT(moveAnimationTimer_timeout()));
-    connect(&spawnAnimationTimer1, SIGNAL(timeout()), this, SLOT(spawnAnimationTimer1_timeout()));
-    connect(&spawnAnimationTimer2, SIGNAL(timeout()), this, SLOT(spawnAnimationTimer2_timeout()));
+    frameTimer.setTimerType(Qt::PreciseTimer);
+    connect(&frameTimer, SIGNAL(timeout()), this, SLOT(frameTimer_timeout()));
 
     gameAreaWinWidget = new GameAreaWinWidget(frameSize, frameRadius);
     gameAreaWinWidget->setParent(this);
@@ -42,95 +39,156 @@ GameArea::GameArea() {
 }
 
 void GameArea::paintEvent(QPaintEvent *event) {
-    QPainter painter(this);
-    painter.setRenderHint(QPainter::Antialiasing);
+    // Also catches the window moving to a screen of another pixel ratio.
+    if (tilePixelRatio != devicePixelRatioF()) render_tiles();
+    update_board_pixmap();
+    // A move after this frame was not cut short by another one.
+    hurried = false;
 
-    painter.setPen(Qt::NoPen);
-    painter.setBrush(frameBrush);
-    painter.drawRoundedRect(frameRect, frameRadius, frameRadius);
-
-    for (int i = 0; i < cellCount; ++i) {
-        for (int j = 0; j < cellCount; ++j) {
-            int number = data[i][j];
-            if (number > 17) {
-                number = 18;
-            }
-            painter.setPen(Qt::NoPen);
-            painter.setBrush(cellBgBrushes[number]);
-            painter.drawRoundedRect(cellRect[i][j], cellRadius, cellRadius);
-            if (number != 0) {
-                painter.setFont(cellTextFonts[number]);
-                painter.setPen(cellTextColors[number]);
-                painter.drawText(cellRect[i][j], Qt::AlignCenter, cellTexts[number]);
-            }
-        }
-    }
+    // Painting is clipped to the region being repainted.
+    QPainter painter(this);
+    painter.drawPixmap(0, 0, boardPixmap);
 
+    qint64 elapsed = animationClock.isValid() ? animationClock.elapsed() : 0;
     if (moveAnimationRunning) {
         for (int i = 0; i < moveAnimationCount; ++i) {
-            auto animation = moveAnimations[i];
-            int n = animation.number;
-            if (n > 17){
-                n = 18;
-            }
-            painter.setPen(Qt::NoPen);
-            painter.setBrush(cellBgBrushes[n]);
-            QRect rect(animation.x, animation.y, cellSize, cellSize);
-            painter.drawRoundedRect(rect, cellRadius, cellRadius);
-            painter.setFont(cellTextFonts[n]);
-            painter.setPen(cellTextColors[n]);
-            painter.drawText(rect, Qt::AlignCenter, cellTexts[n]);
+            draw_tile(painter, move_rect(moveAnimations[i], elapsed), moveAnimations[i].number);
         }
     }
 
-    if (spawnAnimationRunning) {
+    if (spawnAnimationRunning && elapsed >= spawnAnimationStart) {
+        painter.setRenderHint(QPainter::SmoothPixmapTransform);
         for (int i = 0; i < spawnAnimationCount; ++i) {
-            auto animation = spawnAnimations[i];
-            int n = animation.number;
-            if (n > 17){
-                n = 18;
-            }
-            painter.setPen(Qt::NoPen);
-            painter.setBrush(cellBgBrushes[n]);
-            QRect rect(animation.x - spawnAnimationProcess / 4, animation.y - spawnAnimationProcess / 4,
-                       cellSize + spawnAnimationProcess / 2,
-                       cellSize + spawnAnimationProcess / 2);
-            painter.drawRoundedRect(rect, cellRadius, cellRadius);
-            painter.setFont(cellTextFonts[n]);
-            painter.setPen(cellTextColors[n]);
-            painter.drawText(rect, Qt::AlignCenter, cellTexts[n]);
+            draw_tile(painter, spawn_rect(spawnAnimations[i], elapsed), spawnAnimations[i].number);
         }
     }
 
     QWidget::paintEvent(event);
 }
 
-void GameArea::moveAnimationTimer_timeout() {
-    moveAnimationProcess++;
-    for (int i = 0; i < moveAnimationCount; ++i) {
-        moveAnimations[i].x += moveAnimations[i].xSpeed;
-        moveAnimations[i].y += moveAnimations[i].ySpeed;
+QPixmap GameArea::render_tile(int number, int size, qreal pixelRatio) const {
+    QPixmap pixmap(qCeil(size * pixelRatio), qCeil(size * pixelRatio));
+    pixmap.setDevicePixelRatio(pixelRatio);
+    pixmap.fill(Qt::transparent);
+
+    // Tiles past the styled ones look like the last style, which the
+    // settings call INFINITE, but show their value in a font shrunk to fit.
+    int style = qMin(number, styledTiles - 1);
+    QString text = cellTexts[style];
+    QFont font = cellTextFonts[style];
+    if (number >= styledTiles - 1) {
+        text = QString::number(1ULL << number);
+        font = cellTextFonts[17];
+        font.setPointSize(qMax(1, font.pointSize() * cellTexts[17].length() / text.length()));
     }
-    repaint();
-    if (moveAnimationProcess == moveAnimationEndProcess) {
-        end_move_animation();
+
+    QPainter painter(&pixmap);
+    painter.setRenderHint(QPainter::Antialiasing);
+    QRect rect(0, 0, size, size);
+    painter.setPen(Qt::NoPen);
+    painter.setBrush(cellBgBrushes[style]);
+    painter.drawRoundedRect(rect, cellRadius, cellRadius);
+    if (number != 0) {
+        painter.setFont(font);
+        painter.setPen(cellTextColors[style]);
+        painter.drawText(rect, Qt::AlignCenter, text);
     }
+    return pixmap;
 }
 
-void GameArea::spawnAnimationTimer1_timeout() {
-    spawnAnimationProcess++;
-    repaint();
-    if (spawnAnimationProcess == spawnAnimationEndProcess) {
-        end_spawn_animation1();
+void GameArea::render_tiles() {
+    tilePixelRatio = devicePixelRatioF();
+    boardPixmap = QPixmap();
+    int popSize = cellSize + spawnPopSize;
+    for (int n = 0; n <= MAX_WIDE_TILE_EXPONENT; ++n) {
+        bool styled = n < styledTiles;
+        tilePixmaps[n] = styled ? render_tile(n, cellSize, tilePixelRatio) : QPixmap();
+        popPixmaps[n] = styled && n != 0 ? render_tile(n, popSize, tilePixelRatio) : QPixmap();
     }
 }
 
-void GameArea::spawnAnimationTimer2_timeout() {
-    spawnAnimationProcess--;
-    repaint();
-    if (spawnAnimationProcess == 0) {
+void GameArea::draw_tile(QPainter &painter, const QRect &rect, int number) {
+    if (tilePixmaps[number].isNull()) {
+        tilePixmaps[number] = render_tile(number, cellSize, tilePixelRatio);
+        popPixmaps[number] = render_tile(number, cellSize + spawnPopSize, tilePixelRatio);
+    }
+    if (rect.width() == cellSize) {
+        painter.drawPixmap(rect.topLeft(), tilePixmaps[number]);
+    } else {
+        painter.drawPixmap(rect, popPixmaps[number]);
+    }
+}
+
+void GameArea::update_board_pixmap() {
+    bool full = boardPixmap.isNull();
+    if (full) {
+        boardPixmap = QPixmap(qCeil(frameSize * tilePixelRatio), qCeil(frameSize * tilePixelRatio));
+        boardPixmap.setDevicePixelRatio(tilePixelRatio);
+        boardPixmap.fill(Qt::transparent);
+    }
+    QPainter painter(&boardPixmap);
+    if (full) {
+        painter.setRenderHint(QPainter::Antialiasing);
+        painter.setPen(Qt::NoPen);
+        painter.setBrush(frameBrush);
+        painter.drawRoundedRect(frameRect, frameRadius, frameRadius);
+    }
+    for (int i = 0; i < cellCount; ++i) {
+        for (int j = 0; j < cellCount; ++j) {
+            if (!full && boardData[i][j] == data[i][j]) continue;
+            // Clear the old tile first, or its antialiased corners show.
+            if (!full) painter.fillRect(cellRect[i][j], frameBrush);
+            draw_tile(painter, cellRect[i][j], data[i][j]);
+            boardData[i][j] = data[i][j];
+        }
+    }
+}
+
+QRect GameArea::move_rect(const NumberMoveAnimation &animation, qint64 elapsed) const {
+    double progress = qMin(1.0, (double)elapsed / moveDuration);
+    int x = animation.x + qRound((animation.toX - animation.x) * progress);
+    int y = animation.y + qRound((animation.toY - animation.y) * progress);
+    return QRect(x, y, cellSize, cellSize);
+}
+
+QRect GameArea::spawn_rect(const NumberSpawnAnimation &animation, qint64 elapsed) const {
+    // Grows to spawnPopSize and back.
+    double progress = qBound(0.0, (double)(elapsed - spawnAnimationStart) / spawnDuration, 1.0);
+    int grow = qRound(spawnPopSize * (1 - qAbs(2 * progress - 1)));
+    return QRect(animation.x - grow / 2, animation.y - grow / 2, cellSize + grow, cellSize + grow);
+}
+
+// Where the animating tiles are drawn at `elapsed`, with the cells they
+// start from and end on, which change when a phase ends.
+QRegion GameArea::animation_region(qint64 elapsed) const {
+    QRegion region;
+    for (int i = 0; i < moveAnimationCount; ++i) {
+        const NumberMoveAnimation &animation = moveAnimations[i];
+        region += move_rect(animation, elapsed);
+        region += cellRect[animation.fr][animation.fc];
+        region += cellRect[animation.tr][animation.tc];
+    }
+    for (int i = 0; i < spawnAnimationCount; ++i) {
+        region += spawn_rect(spawnAnimations[i], elapsed);
+        region += cellRect[spawnAnimations[i].row][spawnAnimations[i].column];
+    }
+    return region;
+}
+
+void GameArea::frameTimer_timeout() {
+    qint64 elapsed = animationClock.elapsed();
+    if (moveAnimationRunning && elapsed >= moveDuration) {
+        end_move_animation();
+    }
+    if (!moveAnimationRunning && spawnAnimationRunning && elapsed >= spawnAnimationStart + spawnDuration) {
         end_spawn_animation();
     }
+    if (!moveAnimationRunning && !spawnAnimationRunning) {
+        frameTimer.stop();
+    }
+    QRegion region = animation_region(elapsed);
+    update(animationRegion | region);
+    animationRegion = region;
 }
 
 void GameArea::add_move_animation(int fromRow, int fromColumn, int toRow, int toColumn, int number) {
@@ -138,34 +196,18 @@ void GameArea::add_move_animation(int fromRow, int fromColumn, int toRow, int to
     animation.number = number;
     animation.x = frameSep + (cellSize + cellSep) * fromColumn;
     animation.y = frameSep + (cellSize + cellSep) * fromRow;
-    animation.xSpeed = (cellSize + cellSep) * (toColumn - fromColumn) / moveAnimationEndProcess;
-    animation.ySpeed = (cellSize + cellSep) * (toRow - fromRow) / moveAnimationEndProcess;
+    animation.toX = frameSep + (cellSize + cellSep) * toColumn;
+    animation.toY = frameSep + (cellSize + cellSep) * toRow;
     animation.fr = fromRow, animation.fc = fromColumn, animation.tr = toRow, animation.tc = toColumn;
     moveAnimations[moveAnimationCount++] = animation;
 }
 
-void GameArea::begin_move_animation() {
-    if (moveAnimationCount == 0) {
-        begin_spawn_animation();
-        return;
-    }
-    moveAnimationProcess = 0;
-    for (int i = 0; i < moveAnimationCount; ++i) {
-        data[moveAnimations[i].fr][moveAnimations[i].fc] = 0;
-    }
-    moveAnimationRunning = true;
-    moveAnimationTimer.start();
-}
-
 void GameArea::end_move_animation() {
-    moveAnimationTimer.stop();
     for (int i = 0; i < moveAnimationCount; ++i) {
         data[moveAnimations[i].tr][moveAnimations[i].tc] = moveAnimations[i].number;
     }
     moveAnimationCount = 0;
     moveAnimationRunning = false;
-    repaint();
-    begin_spawn_animation();
 }
 
 void GameArea::add_spawn_animation(int row, int column, int number) {
@@ -178,28 +220,12 @@ void GameArea::add_spawn_animation(int row, int column, int number) {
     spawnAnimations[spawnAnimationCount++] = animation;
 }
 
-void GameArea::begin_spawn_animation() {
-    if (spawnAnimationCount == 0) {
-        return;
-    }
-    spawnAnimationProcess = 0;
-    spawnAnimationRunning = true;
-    spawnAnimationTimer1.start();
-}
-
-void GameArea::end_spawn_animation1() {
-    spawnAnimationTimer1.stop();
-    spawnAnimationTimer2.start();
-}
-
 void GameArea::end_spawn_animation() {
-    spawnAnimationTimer2.stop();
     for (int i = 0; i < spawnAnimationCount; ++i) {
         data[spawnAnimations[i].row][spawnAnimations[i].column] = spawnAnimations[i].number;
     }
     spawnAnimationCount = 0;
     spawnAnimationRunning = false;
-    update();
 }
 
 void GameArea::output() {
@@ -213,7 +239,28 @@ void GameArea::output() {
 }
 
 void GameArea::start_animation() {
-    begin_move_animation();
+    for (int i = 0; i < moveAnimationCount; ++i) {
+        data[moveAnimations[i].fr][moveAnimations[i].fc] = 0;
+    }
+    moveAnimationRunning = moveAnimationCount > 0;
+    spawnAnimationRunning = spawnAnimationCount > 0;
+    int divisor = hurried ? hurriedAnimationDivisor : 1;
+    hurried = false;
+    moveDuration = moveAnimationDuration / divisor;
+    spawnDuration = spawnAnimationDuration / divisor;
+    spawnAnimationStart = moveAnimationRunning ? moveDuration : 0;
+    if (!moveAnimationRunning && !spawnAnimationRunning) {
+        return;
+    }
+    animationClock.start();
+    // One frame per screen refresh, at the screen's nominal rate; QWidget::screen()
+    // is why the build asks for Qt 5.14. The timer is not tied to the display's
+    // vertical blank, so a frame can land a refresh late or two in one refresh.
+    // Frames are placed by animationClock, so that shows as a skipped frame, not
+    // a slower animation.
+    frameTimer.start(qMax(1, qRound(1000.0 / screen()->refreshRate())));
+    animationRegion = animation_region(0);
+    update(animationRegion);
     // output();
 }
 
@@ -221,25 +268,33 @@ void GameArea::clear() {
     memset(data, 0, sizeof(data));
 }
 
-void GameArea::stop_animation() {
-    moveAnimationTimer.stop();
-    spawnAnimationTimer1.stop();
-    spawnAnimationTimer2.stop();
-
-    for (int i = 0; i < moveAnimationCount; ++i) {
-        data[moveAnimations[i].tr][moveAnimations[i].tc] = moveAnimations[i].number;
-    }
-    moveAnimationCount = 0;
-    moveAnimationRunning = false;
+void GameArea::set_cell_count(int count) {
+    finish_animation();
+    clear();
+    cellCount = count;
+    frameSize = frame_size(count);
+    frameRect = QRect(0, 0, frameSize, frameSize);
+    boardPixmap = QPixmap();
+    setFixedSize(frameSize, frameSize);
+    gameAreaWinWidget->set_frame_size(frameSize);
+    gameAreaEndWidget->set_cell_count(frameSize, count);
+    update();
+}
 
-    for (int i = 0; i < spawnAnimationCount; ++i) {
-        data[spawnAnimations[i].row][spawnAnimations[i].column] = spawnAnimations[i].number;
-    }
-    spawnAnimationCount = 0;
-    spawnAnimationRunning = false;
+void GameArea::stop_animation() {
+    finish_animation();
     repaint();
 }
 
+void GameArea::finish_animation() {
+    hurried = moveAnimationRunning || spawnAnimationRunning;
+    frameTimer.stop();
+    end_move_animation();
+    end_spawn_animation();
+    update(animationRegion);
+    animationRegion = QRegion();
+}
+
 void GameArea::play_win_animation() {
     auto *animation1 = new QPropertyAnimation(gameAreaGraphicsOpacityEffect, "opacity");
     animation1->setStartValue(0);
@@ -263,6 +318,7 @@ void GameArea::play_end_animation(int row, int column) {
 
 void GameArea::reload_style() {
     gameAreaEndWidget->load_style(cellTexts[17], cellTextFonts[17], cellBgBrushes[17], cellTextColors[17]);
+    render_tiles();
     stop_animation();
     repaint();
 }
@@ -7,16 +7,20 @@
 
 #include <QWidget>
 #include <QTimer>
+#include <QElapsedTimer>
+#include <QPixmap>
+#include <QRegion>
 #include <QGraphicsOpacityEffect>
 #include "GameAreaWinWidget.h"
 #include "GameAreaEndWidget.h"
+#include "GameEngine.h"
 
 struct NumberMoveAnimation {
     int number = 0;
     int x = 0;
     int y = 0;
-    int xSpeed = 0;
-    int ySpeed = 0;
+    int toX = 0;
+    int toY = 0;
     int fr = 0, fc = 0, tr = 0, tc = 0;
 };
 
@@ -38,11 +42,20 @@ public:
     QBrush cellBgBrushes[19] = {};
     QColor cellTextColors[19] = {};
 
-    int data[4][4];
+    // Cells past cellCount are unused.
+    int data[MAX_BOARD_SIZE][MAX_BOARD_SIZE];
     void clear();
+    // Lays the area out for a cellCount x cellCount board and clears it.
+    // Cells keep their size, so the area grows with the board.
+    void set_cell_count(int count);
 
     void start_animation();
+    // Ends the animation at once and repaints.
     void stop_animation();
+    // Ends the animation at once, leaving the repaint to the next frame.
+    // The next start_animation then plays faster, so under fast input
+    // every move is shown without a synchronous repaint per key.
+    void finish_animation();
     void add_move_animation(int fromRow, int fromColumn, int toRow, int toColumn, int number);
     void add_spawn_animation(int row, int column, int number);
 
@@ -59,25 +72,30 @@ public:
     static const int frameSep  = 10;
     static const int frameRadius= 10;
     static const int cellRadius = 3;
-    int frameSize = cellSize * cellCount + cellSep * (cellCount - 1) + frameSep * 2;
+    int frameSize = frame_size(cellCount);
+    static int frame_size(int count) { return cellSize * count + cellSep * (count - 1) + frameSep * 2; }
 
 public slots:
-    void moveAnimationTimer_timeout();
-    void spawnAnimationTimer1_timeout();
-    void spawnAnimationTimer2_timeout();
+    void frameTimer_timeout();
 
 private:
-    void begin_move_animation();
     void end_move_animation();
-    void begin_spawn_animation();
-    void end_spawn_animation1();
     void end_spawn_animation();
 
     void output();
 
+    QPixmap render_tile(int number, int size, qreal pixelRatio) const;
+    void render_tiles();
+    void draw_tile(QPainter &painter, const QRect &rect, int number);
+    void update_board_pixmap();
+
+    QRect move_rect(const NumberMoveAnimation &animation, qint64 elapsed) const;
+    QRect spawn_rect(const NumberSpawnAnimation &animation, qint64 elapsed) const;
+    QRegion animation_region(qint64 elapsed) const;
+
     const QBrush frameBrush = QBrush(QColor(187, 173, 160));
-    const QRect frameRect   = QRect(0, 0, frameSize, frameSize);
-    QRect cellRect[4][4];
+    QRect frameRect = QRect(0, 0, frameSize, frameSize);
+    QRect cellRect[MAX_BOARD_SIZE][MAX_BOARD_SIZE];
 
     /*const QBrush cellBgBrushes[19] = {
             QColor(205, 193, 180), // empty
@@ -145,18 +163,44 @@ private:
             QFont("Microsoft YaHei", 16), // undefined
     };*/
 
-    QTimer moveAnimationTimer;
-    QTimer spawnAnimationTimer1;
-    QTimer spawnAnimationTimer2;
-
-    NumberMoveAnimation moveAnimations[16];
-    NumberSpawnAnimation spawnAnimations[16];
+    // Every tile drawn once at the widget's device pixel ratio, so a frame
+    // is pixmap blits instead of rounded rects and text layout: tilePixmaps
+    // at cellSize, popPixmaps at the largest spawn pop size, which the
+    // smaller pop frames are scaled down from. render_tiles draws the styled
+    // tiles up front; wide boards' bigger tiles are drawn on first use.
+    static const int styledTiles = 19;
+    QPixmap tilePixmaps[MAX_WIDE_TILE_EXPONENT + 1];
+    QPixmap popPixmaps[MAX_WIDE_TILE_EXPONENT + 1];
+    qreal tilePixelRatio = 0;
+
+    // The frame and the cells as in boardData, which paintEvent brings up
+    // to date with data one changed cell at a time; animating tiles are
+    // drawn over it. Frames repaint only animationRegion, where the
+    // animating tiles were and are.
+    QPixmap boardPixmap;
+    int boardData[MAX_BOARD_SIZE][MAX_BOARD_SIZE];
+    QRegion animationRegion;
+
+    // One clock drives every animation: tiles slide for
+    // moveAnimationDuration ms, then the spawned and merged ones pop for
+    // spawnAnimationDuration ms. Frames are placed by the time elapsed, so
+    // a late frame shows the right positions instead of slowing the
+    // animation down, and frameTimer only runs while something moves.
+    QTimer frameTimer;
+    QElapsedTimer animationClock;
+    qint64 spawnAnimationStart = 0;     // ms on animationClock
+    static const int moveAnimationDuration = 100;
+    static const int spawnAnimationDuration = 100;
+    static const int hurriedAnimationDivisor = 3;
+    int moveDuration = moveAnimationDuration;
+    int spawnDuration = spawnAnimationDuration;
+    bool hurried = false;               // finish_animation cut one short since the last paint
+    static const int spawnPopSize = 12; // pixels a popping tile grows by at its peak
+
+    NumberMoveAnimation moveAnimations[MAX_CELL_COUNT];
+    NumberSpawnAnimation spawnAnimations[MAX_CELL_COUNT];
     int moveAnimationCount      = 0;
     int spawnAnimationCount     = 0;
-    int moveAnimationProcess    = 0;
-    int spawnAnimationProcess   = 0;
-    const int moveAnimationEndProcess = 18;
-    const int spawnAnimationEndProcess = 25;
     bool moveAnimationRunning = false;
     bool spawnAnimationRunning = false;
 
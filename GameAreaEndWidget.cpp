@@ -11,16 +11,13 @@ GameAreaEndWidget::GameAreaEndWidget(int s, int csep, int cs, int cr, int fs) {
     cellSep = csep;
     cellRadius = cr;
     frameSep = fs;
-    rectDSize = cellSize * 4 + cellSep * 3 - cellSize;
-    tellHerRect = QRect(0, cellSize * 3 + cellSep * 3, cellSize * 4 + cellSep * 3 + frameSep * 2, cellSize / 3);
     tellHerFont = QFont("Microsoft YaHei", 14);
 
     exitButton = new QPushButton("退出", this);
     exitButton->setFixedSize(cellSize, cellSize / 3);
-    exitButton->move(cellSize * 2 + cellSep * 3 + frameSep * 2 + cellSize / 2 + cellSize / 3, cellSize * 3 + cellSep * 3 + frameSep * 2 + cellSize / 2);
     exitButton->setStyleSheet("background-color: #ffffff; border-radius: 5px;");
 
-    setFixedSize(s, s);
+    set_cell_count(s, 4);
     setAttribute(Qt::WA_TranslucentBackground, true);
 
     connect(&variantAnimation, SIGNAL(valueChanged(QVariant)), this, SLOT(variantAnimationValueChanged(QVariant)));
@@ -28,6 +25,16 @@ GameAreaEndWidget::GameAreaEndWidget(int s, int csep, int cs, int cr, int fs) {
     connect(exitButton, SIGNAL(clicked()), this, SLOT(exitButton_clicked()));
 }
 
+void GameAreaEndWidget::set_cell_count(int s, int n) {
+    // The tile grows to cover every cell; the text and the button sit on
+    // the last row.
+    rectDSize = cellSize * n + cellSep * (n - 1) - cellSize;
+    tellHerRect = QRect(0, cellSize * (n - 1) + cellSep * (n - 1), s, cellSize / 3);
+    exitButton->move(cellSize * (n - 2) + cellSep * (n - 1) + frameSep * 2 + cellSize / 2 + cellSize / 3,
+                     cellSize * (n - 1) + cellSep * (n - 1) + frameSep * 2 + cellSize / 2);
+    setFixedSize(s, s);
+}
+
 void GameAreaEndWidget::paintEvent(QPaintEvent *event) {
     QPainter painter(this);
     painter.setRenderHint(QPainter::Antialiasing);
@@ -17,6 +17,8 @@ public:
     GameAreaEndWidget(int frameSize, int cellSep, int cellSize, int cellRadius,int frameSep);
 
     void paintEvent(QPaintEvent *event) override;
+    // Lays the widget out over a frameSize board of cellCount x cellCount.
+    void set_cell_count(int frameSize, int cellCount);
     void start(int row, int column);
     void load_style(const QString &t, const QFont &textFont, const QBrush &cellBgBrush, const QColor &textColor);
 
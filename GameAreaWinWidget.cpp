@@ -12,6 +12,12 @@ GameAreaWinWidget::GameAreaWinWidget(int s, int r) {
     frameSize = s;
 }
 
+void GameAreaWinWidget::set_frame_size(int s) {
+    setFixedSize(s, s);
+    frameSize = s;
+    update();
+}
+
 void GameAreaWinWidget::paintEvent(QPaintEvent *event) {
     QPainter painter(this);
     painter.setRenderHint(QPainter::Antialiasing);
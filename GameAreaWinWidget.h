@@ -10,6 +10,7 @@
 class GameAreaWinWidget : public QWidget{
 public:
     GameAreaWinWidget(int s, int r);
+    void set_frame_size(int s);
 
     void paintEvent(QPaintEvent *event) override;
 
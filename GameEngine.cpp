@@ -0,0 +1,418 @@
+//
+// Created by Rache on 2026/10/17.
+//
+
+#include "GameEngine.h"
+
+#include <algorithm>
+#include <atomic>
+#include "TableFile.h"
+
+const char *direction_name(Direction d) {
+    switch (d) {
+        case Direction::Up:    return "up";
+        case Direction::Down:  return "down";
+        case Direction::Left:  return "left";
+        case Direction::Right: return "right";
+    }
+    return "";
+}
+
+static Row reverse_row(Row row) {
+    return (Row)((row >> 12) | ((row >> 4) & 0x00f0) | ((row << 4) & 0x0f00) | (row << 12));
+}
+
+static RowTransition slide_row_left(Row row) {
+    int line[BOARD_SIZE];
+    for (int i = 0; i < BOARD_SIZE; ++i) line[i] = (row >> (4 * i)) & 0xf;
+
+    int out[BOARD_SIZE] = {0};
+    bool merged[BOARD_SIZE] = {false};
+    int target = -1;
+    RowTransition transition{};
+    for (int i = 0; i < BOARD_SIZE; ++i) {
+        int n = line[i];
+        if (n == 0) continue;
+        if (target >= 0 && out[target] == n && !merged[target] && n != MAX_TILE_EXPONENT) {
+            out[target]++;
+            merged[target] = true;
+            transition.mergeMask |= 1 << target;
+            transition.score += 1U << out[target];
+        } else {
+            out[++target] = n;
+        }
+    }
+
+    for (int i = 0; i < BOARD_SIZE; ++i) transition.result |= (Row)(out[i] << (4 * i));
+    transition.changed = transition.result != row;
+    return transition;
+}
+
+static const RowTables *build_row_tables() {
+    auto *tables = new RowTables;
+    for (int row = 0; row < (1 << 16); ++row) {
+        tables->left[row] = slide_row_left((Row)row);
+
+        RowTransition mirrored = slide_row_left(reverse_row((Row)row));
+        RowTransition &right = tables->right[row];
+        right.result = reverse_row(mirrored.result);
+        right.mergeMask = 0;
+        for (int i = 0; i < BOARD_SIZE; ++i) {
+            if (mirrored.mergeMask & (1 << i)) right.mergeMask |= 1 << (BOARD_SIZE - 1 - i);
+        }
+        right.changed = mirrored.changed;
+        right.score = mirrored.score;
+    }
+    return tables;
+}
+
+// Never unmapped, like the built tables are never freed.
+static TableFile &rowTableFile = *new TableFile;
+static std::atomic<bool> rowTablesInUse(false);
+
+const RowTables &row_tables() {
+    static const RowTables *tables = [] {
+        rowTablesInUse = true;
+        if (rowTableFile.is_open()) return (const RowTables *)rowTableFile.payload();
+        return build_row_tables();
+    }();
+    return *tables;
+}
+
+// Changes whenever the meaning of the tables may change; bump the last
+// field when the rules change in a way the spot check below cannot see.
+static uint64_t row_table_layout() {
+    const uint32_t fields[] = {BOARD_SIZE, MAX_TILE_EXPONENT, (uint32_t)sizeof(RowTransition),
+                               (uint32_t)sizeof(RowTables), 1};
+    return TableFile::hash(fields, sizeof(fields));
+}
+
+bool save_row_tables(const std::string &path) {
+    return TableFile::write(path, TableKind::RowTables, row_table_layout(), nullptr, 0,
+                            &row_tables(), sizeof(RowTables));
+}
+
+bool load_row_tables(const std::string &path) {
+    if (rowTablesInUse) return false;
+    TableFile &file = rowTableFile;
+    if (!file.open(path, TableKind::RowTables, row_table_layout()) || file.payload_size() != sizeof(RowTables)) {
+        file.close();
+        return false;
+    }
+    // Spot check some rows against the rules as they are now.
+    const auto *tables = (const RowTables *)file.payload();
+    GameRandom random(0x2048);
+    for (int i = 0; i < 256; ++i) {
+        auto row = (Row)random.next();
+        RowTransition expected = slide_row_left(row);
+        const RowTransition &found = tables->left[row];
+        if (found.result != expected.result || found.score != expected.score ||
+            found.mergeMask != expected.mergeMask || found.changed != expected.changed) {
+            file.close();
+            return false;
+        }
+    }
+    return true;
+}
+
+int board_empty_count(Board b) {
+    if (b == 0) return CELL_COUNT;
+    // Fold every nibble onto its lowest bit, then count the zero nibbles.
+    b |= b >> 2;
+    b |= b >> 1;
+    b = ~b & 0x1111111111111111ULL;
+    return (int)((b * 0x1111111111111111ULL) >> 60);
+}
+
+int board_max_tile(Board b) {
+    int m = 0;
+    for (int i = 0; i < CELL_COUNT; ++i, b >>= 4) {
+        int n = (int)(b & 0xf);
+        if (n > m) m = n;
+    }
+    return m;
+}
+
+static Board move_rows(Board b, const RowTransition *table, int64_t *score) {
+    const RowTransition &r0 = table[(Row)b];
+    const RowTransition &r1 = table[(Row)(b >> 16)];
+    const RowTransition &r2 = table[(Row)(b >> 32)];
+    const RowTransition &r3 = table[(Row)(b >> 48)];
+    if (score) *score += (int64_t)r0.score + r1.score + r2.score + r3.score;
+    return (Board)r0.result | ((Board)r1.result << 16) | ((Board)r2.result << 32) | ((Board)r3.result << 48);
+}
+
+Board board_move(Board b, Direction d, int64_t *score) {
+    const RowTables &tables = row_tables();
+    switch (d) {
+        case Direction::Up:
+            return board_transpose(move_rows(board_transpose(b), tables.left, score));
+        case Direction::Down:
+            return board_transpose(move_rows(board_transpose(b), tables.right, score));
+        case Direction::Left:
+            return move_rows(b, tables.left, score);
+        case Direction::Right:
+            return move_rows(b, tables.right, score);
+    }
+    return b;
+}
+
+static int rows_legal_moves(Board b, const RowTables &tables) {
+    int left = 0, right = 0;
+    for (int r = 0; r < BOARD_SIZE; ++r, b >>= 16) {
+        left |= tables.left[(Row)b].changed;
+        right |= tables.right[(Row)b].changed;
+    }
+    return left | right << 1;
+}
+
+int board_legal_moves(Board b) {
+    const RowTables &tables = row_tables();
+    return rows_legal_moves(board_transpose(b), tables) | rows_legal_moves(b, tables) << 2;
+}
+
+bool board_can_move(Board b) {
+    return board_legal_moves(b) != 0;
+}
+
+int wide_max_tile(WideBoard b) {
+    if (b.high == 0) return board_max_tile(b.low);
+    int m = 0;
+    for (int i = 0; i < CELL_COUNT; ++i) m = std::max(m, wide_get(b, i / BOARD_SIZE, i % BOARD_SIZE));
+    return m;
+}
+
+Board wide_capped(WideBoard b) {
+    // Every nibble of `over` is 0xf where high is set.
+    Board over = b.high | b.high >> 1 | b.high >> 2 | b.high >> 3;
+    over = (over & 0x1111111111111111ULL) * 0xf;
+    return b.low | over;
+}
+
+// Slides one line of tile exponents towards index 0.
+static void slide_line(int line[BOARD_SIZE], int64_t *score) {
+    int out[BOARD_SIZE] = {0};
+    bool merged[BOARD_SIZE] = {false};
+    int target = -1;
+    for (int i = 0; i < BOARD_SIZE; ++i) {
+        int n = line[i];
+        if (n == 0) continue;
+        if (target >= 0 && out[target] == n && !merged[target] && n < MAX_WIDE_TILE_EXPONENT) {
+            out[target]++;
+            merged[target] = true;
+            if (score) *score += 1LL << out[target];
+        } else {
+            out[++target] = n;
+        }
+    }
+    for (int i = 0; i < BOARD_SIZE; ++i) line[i] = out[i];
+}
+
+// move_rows for a WideBoard: the table for rows that fit it, cell by cell
+// for the rest.
+static WideBoard move_wide_rows(WideBoard b, const RowTransition *table, bool right, int64_t *score) {
+    WideBoard result;
+    for (int r = 0; r < BOARD_SIZE; ++r) {
+        auto low = (Row)(b.low >> (16 * r));
+        auto high = (Row)(b.high >> (16 * r));
+        if (high == 0 && !board_holds_max_tile(low)) {
+            const RowTransition &t = table[low];
+            if (score) *score += t.score;
+            result.low |= (Board)t.result << (16 * r);
+            continue;
+        }
+        int line[BOARD_SIZE];
+        for (int i = 0; i < BOARD_SIZE; ++i) {
+            int cell = right ? BOARD_SIZE - 1 - i : i;
+            line[i] = (low >> (4 * cell) & 0xf) | (high >> (4 * cell) & 0xf) << 4;
+        }
+        slide_line(line, score);
+        for (int i = 0; i < BOARD_SIZE; ++i) {
+            int cell = right ? BOARD_SIZE - 1 - i : i;
+            result.low |= (Board)(line[i] & 0xf) << (16 * r + 4 * cell);
+            result.high |= (Board)(line[i] >> 4) << (16 * r + 4 * cell);
+        }
+    }
+    return result;
+}
+
+WideBoard wide_move(WideBoard b, Direction d, int64_t *score) {
+    if (b.high == 0 && !board_holds_max_tile(b.low)) return {board_move(b.low, d, score), 0};
+    const RowTables &tables = row_tables();
+    WideBoard t{board_transpose(b.low), board_transpose(b.high)};
+    WideBoard moved;
+    switch (d) {
+        case Direction::Up:
+            moved = move_wide_rows(t, tables.left, false, score);
+            return {board_transpose(moved.low), board_transpose(moved.high)};
+        case Direction::Down:
+            moved = move_wide_rows(t, tables.right, true, score);
+            return {board_transpose(moved.low), board_transpose(moved.high)};
+        case Direction::Left:
+            return move_wide_rows(b, tables.left, false, score);
+        case Direction::Right:
+            return move_wide_rows(b, tables.right, true, score);
+    }
+    return b;
+}
+
+int wide_legal_moves(WideBoard b) {
+    if (b.high == 0 && !board_holds_max_tile(b.low)) return board_legal_moves(b.low);
+    int legal = 0;
+    for (int d = 0; d < 4; ++d) {
+        if (wide_move(b, (Direction)d) != b) legal |= 1 << d;
+    }
+    return legal;
+}
+
+bool wide_can_move(WideBoard b) {
+    return wide_legal_moves(b) != 0;
+}
+
+// Maps position p of line `line` (p = 0 is the cell at the wall the tiles
+// slide towards) to a board coordinate.
+static void line_cell(Direction d, int line, int p, int *row, int *column) {
+    switch (d) {
+        case Direction::Up:    *row = p;                  *column = line; break;
+        case Direction::Down:  *row = BOARD_SIZE - 1 - p; *column = line; break;
+        case Direction::Left:  *row = line; *column = p;                  break;
+        default:               *row = line; *column = BOARD_SIZE - 1 - p; break;
+    }
+}
+
+Board board_move_trace(Board b, Direction d, MoveTrace *trace, int64_t *score) {
+    trace->tileCount = 0;
+    Board result = 0;
+    for (int line = 0; line < BOARD_SIZE; ++line) {
+        int out[BOARD_SIZE] = {0};
+        bool merged[BOARD_SIZE] = {false};
+        int target = -1;
+        for (int p = 0; p < BOARD_SIZE; ++p) {
+            int fr, fc;
+            line_cell(d, line, p, &fr, &fc);
+            int n = board_get(b, fr, fc);
+            if (n == 0) continue;
+
+            TileMove tile;
+            tile.fr = fr, tile.fc = fc, tile.number = n;
+            if (target >= 0 && out[target] == n && !merged[target] && n != MAX_TILE_EXPONENT) {
+                out[target]++;
+                merged[target] = true;
+                tile.merged = out[target];
+                if (score) *score += 1LL << out[target];
+            } else {
+                out[++target] = n;
+                if (target == p) continue;
+            }
+            line_cell(d, line, target, &tile.tr, &tile.tc);
+            trace->tiles[trace->tileCount++] = tile;
+        }
+        for (int p = 0; p < BOARD_SIZE; ++p) {
+            int r, c;
+            line_cell(d, line, p, &r, &c);
+            result = board_set(result, r, c, out[p]);
+        }
+    }
+    return result;
+}
+
+WideBoard wide_move_trace(WideBoard b, Direction d, MoveTrace *trace, int64_t *score) {
+    trace->tileCount = 0;
+    WideBoard result;
+    for (int line = 0; line < BOARD_SIZE; ++line) {
+        int out[BOARD_SIZE] = {0};
+        bool merged[BOARD_SIZE] = {false};
+        int target = -1;
+        for (int p = 0; p < BOARD_SIZE; ++p) {
+            int fr, fc;
+            line_cell(d, line, p, &fr, &fc);
+            int n = wide_get(b, fr, fc);
+            if (n == 0) continue;
+
+            TileMove tile;
+            tile.fr = fr, tile.fc = fc, tile.number = n;
+            if (target >= 0 && out[target] == n && !merged[target] && n < MAX_WIDE_TILE_EXPONENT) {
+                out[target]++;
+                merged[target] = true;
+                tile.merged = out[target];
+                if (score) *score += 1LL << out[target];
+            } else {
+                out[++target] = n;
+                if (target == p) continue;
+            }
+            line_cell(d, line, target, &tile.tr, &tile.tc);
+            trace->tiles[trace->tileCount++] = tile;
+        }
+        for (int p = 0; p < BOARD_SIZE; ++p) {
+            int r, c;
+            line_cell(d, line, p, &r, &c);
+            result = wide_set(result, r, c, out[p]);
+        }
+    }
+    return result;
+}
+
+Board board_spawn(Board b, GameRandom &random, int *row, int *column, int *number) {
+    int emptyCells[CELL_COUNT];
+    int emptyCount = 0;
+    Board t = b;
+    for (int i = 0; i < CELL_COUNT; ++i, t >>= 4) {
+        if ((t & 0xf) == 0) emptyCells[emptyCount++] = i;
+    }
+    if (emptyCount == 0) return b;
+
+    int index = emptyCells[random.bounded(emptyCount)];
+    int n = random.bounded(10) == 0 ? 2 : 1;
+    if (row) *row = index / BOARD_SIZE;
+    if (column) *column = index % BOARD_SIZE;
+    if (number) *number = n;
+    return b | ((Board)n << (4 * index));
+}
+
+WideBoard wide_spawn(WideBoard b, GameRandom &random, int *row, int *column, int *number) {
+    int r, c, n;
+    Board occupied = b.low | b.high;
+    if (board_spawn(occupied, random, &r, &c, &n) == occupied) return b;
+    if (row) *row = r;
+    if (column) *column = c;
+    if (number) *number = n;
+    return {board_set(b.low, r, c, n), b.high};
+}
+
+GameEngine::GameEngine(uint64_t seed) : random(seed) {
+}
+
+void GameEngine::clear() {
+    board = 0;
+    high = 0;
+    score = 0;
+}
+
+void GameEngine::new_game() {
+    clear();
+    spawn();
+    spawn();
+}
+
+bool GameEngine::move(Direction d, MoveTrace *trace) {
+    int64_t gained = 0;
+    WideBoard before = wide_board();
+    WideBoard next = trace ? wide_move_trace(before, d, trace, &gained) : wide_move(before, d, &gained);
+    if (next == before) return false;
+    set_wide_board(next);
+    score += gained;
+    if (trace) {
+        spawn(&trace->spawnRow, &trace->spawnColumn, &trace->spawnNumber);
+    } else {
+        spawn();
+    }
+    return true;
+}
+
+bool GameEngine::spawn(int *row, int *column, int *number) {
+    WideBoard before = wide_board();
+    WideBoard next = wide_spawn(before, random, row, column, number);
+    if (next == before) return false;
+    set_wide_board(next);
+    return true;
+}
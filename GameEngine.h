@@ -0,0 +1,222 @@
+//
+// Created by Rache on 2026/10/17.
+//
+
+#ifndef INC_2048GAME_GAMEENGINE_H
+#define INC_2048GAME_GAMEENGINE_H
+
+#include <cstdint>
+#include <string>
+
+// The board is packed into a single 64-bit integer, one nibble per cell.
+// Cell (row, column) lives at bits 4 * (row * 4 + column), so each row is
+// a 16-bit value whose lowest nibble is the leftmost cell. A nibble holds
+// the tile exponent: 0 is empty, 1 is 2, 2 is 4, ... 15 is 32768.
+typedef uint64_t Board;
+typedef uint16_t Row;
+
+static const int BOARD_SIZE = 4;
+static const int CELL_COUNT = BOARD_SIZE * BOARD_SIZE;
+static const int MAX_TILE_EXPONENT = 15;
+
+// Games go past MAX_TILE_EXPONENT with wider cells, up to
+// MAX_WIDE_TILE_EXPONENT, which keeps the score of a merge in an int64_t:
+// 4x4 games with a WideBoard below, other sizes with GridGame, see
+// GridEngine.h.
+static const int MAX_WIDE_TILE_EXPONENT = 62;
+static const int MIN_BOARD_SIZE = 3;
+static const int MAX_BOARD_SIZE = 8;
+static const int MAX_CELL_COUNT = MAX_BOARD_SIZE * MAX_BOARD_SIZE;
+
+enum class Direction : int {
+    Up = 0,
+    Down = 1,
+    Left = 2,
+    Right = 3
+};
+
+// Lower-case names, the same as the run_cmd commands.
+const char *direction_name(Direction d);
+
+// splitmix64: a 64-bit state is the whole generator, so it is trivially
+// seeded, copied and serialized, and produces the same stream everywhere.
+class GameRandom {
+public:
+    explicit GameRandom(uint64_t seed = 0) : state(seed) {}
+
+    void seed(uint64_t s) { state = s; }
+
+    uint64_t next() {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    // Uniform integer in [0, n).
+    unsigned bounded(unsigned n) {
+        return (unsigned)(((next() >> 32) * (uint64_t)n) >> 32);
+    }
+
+    uint64_t state;
+};
+
+// What sliding one 16-bit row towards its low (left) or high (right) end
+// does. Tables of these for all 65536 rows turn a move into four lookups.
+struct RowTransition {
+    Row result;
+    uint8_t mergeMask;  // bit i is set when cell i received a merge
+    uint8_t changed;
+    uint32_t score;
+};
+
+struct RowTables {
+    RowTransition left[1 << 16];
+    RowTransition right[1 << 16];
+};
+
+// Built once on first use, unless load_row_tables mapped a file before.
+const RowTables &row_tables();
+
+// Saves the tables in the mappable format of TableFile.h.
+bool save_row_tables(const std::string &path);
+// Maps tables written by save_row_tables and uses them in place instead of
+// building them. Only works before the first move; returns false and
+// leaves the tables alone when the file is missing, was written by another
+// build or disagrees with the rules, or the tables are already in use.
+bool load_row_tables(const std::string &path);
+
+struct TileMove {
+    int fr = 0, fc = 0, tr = 0, tc = 0;
+    int number = 0;
+    int merged = 0;     // resulting exponent when this tile merges into (tr, tc), else 0
+};
+
+struct MoveTrace {
+    TileMove tiles[MAX_CELL_COUNT];
+    int tileCount = 0;
+    int spawnRow = -1, spawnColumn = -1, spawnNumber = 0;
+};
+
+inline int board_get(Board b, int row, int column) {
+    return (int)((b >> (4 * (row * BOARD_SIZE + column))) & 0xf);
+}
+
+inline Board board_set(Board b, int row, int column, int number) {
+    int shift = 4 * (row * BOARD_SIZE + column);
+    if (number > MAX_TILE_EXPONENT) number = MAX_TILE_EXPONENT;
+    if (number < 0) number = 0;
+    return (b & ~(0xfULL << shift)) | ((Board)number << shift);
+}
+
+inline Row board_row(Board b, int row) {
+    return (Row)(b >> (16 * row));
+}
+
+// Swaps rows and columns, so up/down moves can reuse the row tables.
+inline Board board_transpose(Board b) {
+    Board a1 = b & 0xF0F00F0FF0F00F0FULL;
+    Board a2 = b & 0x0000F0F00000F0F0ULL;
+    Board a3 = b & 0x0F0F00000F0F0000ULL;
+    Board a = a1 | (a2 << 12) | (a3 >> 12);
+    Board b1 = a & 0xFF00FF0000FF00FFULL;
+    Board b2 = a & 0x00FF00FF00000000ULL;
+    Board b3 = a & 0x00000000FF00FF00ULL;
+    return b1 | (b2 >> 24) | (b3 << 24);
+}
+
+int board_empty_count(Board b);
+int board_max_tile(Board b);
+
+// Slides and merges the board in one direction. Returns the new board and
+// adds the merged tile values to *score when score is not null. Two
+// MAX_TILE_EXPONENT tiles stay apart, as their merge does not fit a nibble;
+// games play with wide_move, which merges them.
+Board board_move(Board b, Direction d, int64_t *score = nullptr);
+bool board_can_move(Board b);
+// Bit d is set when Direction d changes the board.
+int board_legal_moves(Board b);
+
+// Same as board_move, but also records where every tile went. This is the
+// slow path used by the GUI for animations; simulations never need it.
+Board board_move_trace(Board b, Direction d, MoveTrace *trace, int64_t *score = nullptr);
+
+// Places a 2 (90%) or a 4 (10%) on a uniformly chosen empty cell, scanning
+// the empty cells in row-major order like MainWindow::random_spawn_number.
+Board board_spawn(Board b, GameRandom &random, int *row = nullptr, int *column = nullptr, int *number = nullptr);
+
+// True when some cell of b holds MAX_TILE_EXPONENT, the one tile whose
+// merge a Board cannot hold.
+inline bool board_holds_max_tile(Board b) {
+    return (b & (b >> 1) & (b >> 2) & (b >> 3) & 0x1111111111111111ULL) != 0;
+}
+
+// A 4x4 board past the nibble range. `low` holds the low nibble of every
+// tile exponent, laid out like a Board, and `high` the high nibble, so a
+// WideBoard with high = 0 is exactly the Board in low. The wide_*
+// functions take the Board path, row tables included, for every row that
+// holds no tile of MAX_TILE_EXPONENT or more, and slide only the others
+// cell by cell.
+struct WideBoard {
+    Board low = 0;
+    Board high = 0;
+
+    bool operator==(const WideBoard &other) const { return low == other.low && high == other.high; }
+    bool operator!=(const WideBoard &other) const { return !(*this == other); }
+};
+
+inline int wide_get(WideBoard b, int row, int column) {
+    return board_get(b.low, row, column) | board_get(b.high, row, column) << 4;
+}
+
+inline WideBoard wide_set(WideBoard b, int row, int column, int number) {
+    if (number > MAX_WIDE_TILE_EXPONENT) number = MAX_WIDE_TILE_EXPONENT;
+    if (number < 0) number = 0;
+    return {board_set(b.low, row, column, number & 0xf), board_set(b.high, row, column, number >> 4)};
+}
+
+// A cell is empty when both of its nibbles are.
+inline int wide_empty_count(WideBoard b) { return board_empty_count(b.low | b.high); }
+int wide_max_tile(WideBoard b);
+// The Board closest to b for evaluators that index tiles by nibble: every
+// tile past MAX_TILE_EXPONENT counts as MAX_TILE_EXPONENT.
+Board wide_capped(WideBoard b);
+
+WideBoard wide_move(WideBoard b, Direction d, int64_t *score = nullptr);
+bool wide_can_move(WideBoard b);
+int wide_legal_moves(WideBoard b);
+WideBoard wide_move_trace(WideBoard b, Direction d, MoveTrace *trace, int64_t *score = nullptr);
+// Draws from `random` exactly like board_spawn.
+WideBoard wide_spawn(WideBoard b, GameRandom &random, int *row = nullptr, int *column = nullptr, int *number = nullptr);
+
+// Plays on `board` alone while every tile fits a nibble, and with `high`
+// once a tile goes past MAX_TILE_EXPONENT; high is 0 in every game that
+// never gets there.
+class GameEngine {
+public:
+    explicit GameEngine(uint64_t seed = 0);
+
+    void new_game();
+    void clear();
+    bool move(Direction d, MoveTrace *trace = nullptr);
+    bool spawn(int *row = nullptr, int *column = nullptr, int *number = nullptr);
+    bool can_move() const { return wide_can_move(wide_board()); }
+
+    int get(int row, int column) const { return wide_get(wide_board(), row, column); }
+    void set(int row, int column, int number) { set_wide_board(wide_set(wide_board(), row, column, number)); }
+    int max_tile() const { return wide_max_tile(wide_board()); }
+
+    WideBoard wide_board() const { return {board, high}; }
+    void set_wide_board(WideBoard b) {
+        board = b.low;
+        high = b.high;
+    }
+
+    Board board = 0;
+    Board high = 0;
+    int64_t score = 0;
+    GameRandom random;
+};
+
+
+#endif //INC_2048GAME_GAMEENGINE_H
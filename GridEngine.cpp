@@ -0,0 +1,238 @@
+//
+// Created by Rache on 2026/10/17.
+//
+
+#include "GridEngine.h"
+
+template<int N, bool WIDE>
+struct GridKernel {
+    static const int BITS = WIDE ? 8 : 4;
+    static const int CELLS_PER_WORD = 64 / BITS;
+    static const int WORDS = (N * N + CELLS_PER_WORD - 1) / CELLS_PER_WORD;
+    static const int MAX_EXPONENT = WIDE ? MAX_WIDE_TILE_EXPONENT : MAX_TILE_EXPONENT;
+    static const uint64_t MASK = (1ULL << BITS) - 1;
+
+    // Cell p of line `line` is origin + line * lineStep + p * cellStep,
+    // with p = 0 at the wall the tiles slide towards.
+    struct Lines {
+        int origin, lineStep, cellStep;
+    };
+
+    static Lines lines(Direction d) {
+        switch (d) {
+            case Direction::Up:    return {0, 1, N};
+            case Direction::Down:  return {(N - 1) * N, 1, -N};
+            case Direction::Left:  return {0, N, 1};
+            default:               return {N - 1, N, -1};
+        }
+    }
+
+    static int get(const GridBoard &b, int cell) {
+        return (int)((b.words[cell / CELLS_PER_WORD] >> (BITS * (cell % CELLS_PER_WORD))) & MASK);
+    }
+
+    static bool move(GridBoard &b, Direction d, int64_t *score, MoveTrace *trace) {
+        Lines l = lines(d);
+        if (trace) trace->tileCount = 0;
+        GridBoard result;
+        result.wide = WIDE;
+        for (int line = 0; line < N; ++line) {
+            int first = l.origin + line * l.lineStep;
+            int out[N] = {0};
+            bool merged[N] = {false};
+            int target = -1;
+            for (int p = 0; p < N; ++p) {
+                int from = first + p * l.cellStep;
+                int n = get(b, from);
+                if (n == 0) continue;
+
+                int mergedInto = 0;
+                if (target >= 0 && out[target] == n && !merged[target] && n != MAX_EXPONENT) {
+                    mergedInto = ++out[target];
+                    merged[target] = true;
+                    if (score) *score += 1LL << mergedInto;
+                } else {
+                    out[++target] = n;
+                    if (target == p) continue;
+                }
+                if (trace) {
+                    int to = first + target * l.cellStep;
+                    TileMove &tile = trace->tiles[trace->tileCount++];
+                    tile.fr = from / N, tile.fc = from % N, tile.tr = to / N, tile.tc = to % N;
+                    tile.number = n;
+                    tile.merged = mergedInto;
+                }
+            }
+            // result starts empty, so the tiles can be ORed in.
+            for (int p = 0; p <= target; ++p) {
+                int to = first + p * l.cellStep;
+                result.words[to / CELLS_PER_WORD] |= (uint64_t)out[p] << (BITS * (to % CELLS_PER_WORD));
+            }
+        }
+
+        bool changed = false;
+        for (int i = 0; i < WORDS; ++i) changed |= result.words[i] != b.words[i];
+        b = result;
+        return changed;
+    }
+
+    // A board with both tiles and empty cells has a tile next to an empty
+    // cell, which can slide into it.
+    static bool can_move(const GridBoard &b) {
+        bool empty = false, tiles = false;
+        for (int r = 0; r < N; ++r) {
+            for (int c = 0; c < N; ++c) {
+                int n = get(b, r * N + c);
+                empty |= n == 0;
+                tiles |= n != 0;
+                if (n == 0 || n == MAX_EXPONENT) continue;
+                if (c + 1 < N && get(b, r * N + c + 1) == n) return true;
+                if (r + 1 < N && get(b, (r + 1) * N + c) == n) return true;
+            }
+        }
+        return empty && tiles;
+    }
+};
+
+// Compact 4x4 boards are Boards, so the row tables move them.
+template<>
+struct GridKernel<4, false> {
+    static bool move(GridBoard &b, Direction d, int64_t *score, MoveTrace *trace) {
+        Board next = trace ? board_move_trace(b.words[0], d, trace, score) : board_move(b.words[0], d, score);
+        if (next == b.words[0]) return false;
+        b.words[0] = next;
+        return true;
+    }
+
+    static bool can_move(const GridBoard &b) {
+        return board_can_move(b.words[0]);
+    }
+};
+
+template<int N, bool WIDE>
+static const GridKernels &kernels_of() {
+    static const GridKernels kernels = {&GridKernel<N, WIDE>::move, &GridKernel<N, WIDE>::can_move};
+    return kernels;
+}
+
+template<bool WIDE>
+static const GridKernels &kernels_of(int size) {
+    switch (size) {
+        case 3:  return kernels_of<3, WIDE>();
+        case 5:  return kernels_of<5, WIDE>();
+        case 6:  return kernels_of<6, WIDE>();
+        case 7:  return kernels_of<7, WIDE>();
+        case 8:  return kernels_of<8, WIDE>();
+        default: return kernels_of<4, WIDE>();
+    }
+}
+
+const GridKernels &grid_kernels(int size, bool wide) {
+    return wide ? kernels_of<true>(size) : kernels_of<false>(size);
+}
+
+static_assert(MIN_BOARD_SIZE == 3 && MAX_BOARD_SIZE == 8, "grid_kernels covers sizes 3 to 8");
+static_assert(MAX_WIDE_TILE_EXPONENT < 256, "wide cells are a byte");
+
+// Whether a compact board holds a MAX_TILE_EXPONENT, an all-ones nibble.
+static bool compact_full(const GridBoard &b) {
+    uint64_t full = 0;
+    for (int i = 0; i < MAX_CELL_COUNT / 16; ++i) {
+        uint64_t w = b.words[i];
+        full |= w & (w >> 1) & (w >> 2) & (w >> 3) & 0x1111111111111111ULL;
+    }
+    return full != 0;
+}
+
+static GridBoard widened(const GridBoard &b, int cellCount) {
+    GridBoard wide;
+    wide.wide = true;
+    for (int i = 0; i < cellCount; ++i) wide.set(i, b.get(i));
+    return wide;
+}
+
+GridGame::GridGame(int size, uint64_t seed) : random(seed) {
+    resize(size);
+}
+
+void GridGame::resize(int size) {
+    if (size < MIN_BOARD_SIZE) size = MIN_BOARD_SIZE;
+    if (size > MAX_BOARD_SIZE) size = MAX_BOARD_SIZE;
+    boardSize = size;
+    kernels[0] = &grid_kernels(size, false);
+    kernels[1] = &grid_kernels(size, true);
+    clear();
+}
+
+void GridGame::clear() {
+    board = GridBoard();
+    score = 0;
+}
+
+void GridGame::new_game() {
+    clear();
+    spawn();
+    spawn();
+}
+
+bool GridGame::move(Direction d, MoveTrace *trace) {
+    int64_t gained = 0;
+    if (!kernels[board.wide]->move(board, d, &gained, trace)) return false;
+    score += gained;
+    widen_if_full();
+    if (trace) {
+        spawn(&trace->spawnRow, &trace->spawnColumn, &trace->spawnNumber);
+    } else {
+        spawn();
+    }
+    return true;
+}
+
+GridBoard GridGame::moved(Direction d, int64_t *score) const {
+    GridBoard next = board;
+    kernels[board.wide]->move(next, d, score, nullptr);
+    return next;
+}
+
+void GridGame::set(int row, int column, int number) {
+    board.set(row * boardSize + column, number);
+    widen_if_full();
+    // A number past the compact range was clamped to MAX_TILE_EXPONENT and
+    // has just been widened; set it again in full.
+    if (number > MAX_TILE_EXPONENT) board.set(row * boardSize + column, number);
+}
+
+void GridGame::widen_if_full() {
+    if (!board.wide && compact_full(board)) board = widened(board, cell_count());
+}
+
+bool GridGame::spawn(int *row, int *column, int *number) {
+    int emptyCells[MAX_CELL_COUNT];
+    int emptyCount = 0;
+    for (int i = 0; i < cell_count(); ++i) {
+        if (board.get(i) == 0) emptyCells[emptyCount++] = i;
+    }
+    if (emptyCount == 0) return false;
+
+    int index = emptyCells[random.bounded(emptyCount)];
+    int n = random.bounded(10) == 0 ? 2 : 1;
+    if (row) *row = index / boardSize;
+    if (column) *column = index % boardSize;
+    if (number) *number = n;
+    board.set(index, n);
+    return true;
+}
+
+int GridGame::empty_count(const GridBoard &b) const {
+    int count = 0;
+    for (int i = 0; i < cell_count(); ++i) count += b.get(i) == 0;
+    return count;
+}
+
+int GridGame::max_tile() const {
+    int m = 0;
+    for (int i = 0; i < cell_count(); ++i) {
+        if (board.get(i) > m) m = board.get(i);
+    }
+    return m;
+}
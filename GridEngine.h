@@ -0,0 +1,113 @@
+//
+// Created by Rache on 2026/10/17.
+//
+
+#ifndef INC_2048GAME_GRIDENGINE_H
+#define INC_2048GAME_GRIDENGINE_H
+
+#include <cstdint>
+#include "GameEngine.h"
+
+// A board of any size from MIN_BOARD_SIZE to MAX_BOARD_SIZE, packed like a
+// Board: cell i = row * size + column is the nibble at bit 4 * (i % 16) of
+// words[i / 16]. A 3x3 board takes 36 bits of one word, a 4x4 board is
+// exactly a Board in words[0], a 5x5 board takes 100 bits of two words and
+// an 8x8 board four.
+//
+// A wide board holds a byte per cell instead, cell i at bit 8 * (i % 8) of
+// words[i / 8], so a 4x4 board takes 128 bits and an 8x8 board all eight
+// words. Tiles go up to MAX_WIDE_TILE_EXPONENT.
+//
+// Bits past the last cell stay zero, so two boards of one size compare
+// equal exactly when their cells do.
+struct GridBoard {
+    uint64_t words[MAX_CELL_COUNT / 8] = {};
+    bool wide = false;
+
+    int get(int cell) const {
+        if (wide) return (int)((words[cell >> 3] >> (8 * (cell & 7))) & 0xff);
+        return (int)((words[cell >> 4] >> (4 * (cell & 15))) & 0xf);
+    }
+
+    void set(int cell, int number) {
+        int max = wide ? MAX_WIDE_TILE_EXPONENT : MAX_TILE_EXPONENT;
+        if (number > max) number = max;
+        if (number < 0) number = 0;
+        if (wide) {
+            int shift = 8 * (cell & 7);
+            words[cell >> 3] = (words[cell >> 3] & ~(0xffULL << shift)) | ((uint64_t)number << shift);
+        } else {
+            int shift = 4 * (cell & 15);
+            words[cell >> 4] = (words[cell >> 4] & ~(0xfULL << shift)) | ((uint64_t)number << shift);
+        }
+    }
+
+    bool operator==(const GridBoard &other) const {
+        if (wide != other.wide) return false;
+        for (int i = 0; i < MAX_CELL_COUNT / 8; ++i) {
+            if (words[i] != other.words[i]) return false;
+        }
+        return true;
+    }
+    bool operator!=(const GridBoard &other) const { return !(*this == other); }
+};
+
+// The moves for one board size and cell width. Every pair has its own
+// kernels, compiled with both as constants so the line loops unroll and
+// only the words in use are touched; the compact 4x4 kernels are the Board
+// row tables.
+struct GridKernels {
+    // Slides and merges `b` in place; returns whether anything moved.
+    bool (*move)(GridBoard &b, Direction d, int64_t *score, MoveTrace *trace);
+    bool (*can_move)(const GridBoard &b);
+};
+
+const GridKernels &grid_kernels(int size, bool wide);
+
+// GameEngine for every board size. The spawns draw from the random state
+// exactly like board_spawn, so a 4x4 GridGame plays the same game as a
+// GameEngine with the same seed.
+//
+// Boards start compact. The moment a tile reaches MAX_TILE_EXPONENT, the
+// most a nibble holds, the board is widened and play goes on with the wide
+// kernels, so games that never get there keep the packed path. Compact
+// boards therefore never hold a MAX_TILE_EXPONENT.
+class GridGame {
+public:
+    // size is clamped to [MIN_BOARD_SIZE, MAX_BOARD_SIZE].
+    explicit GridGame(int size = BOARD_SIZE, uint64_t seed = 0);
+
+    int size() const { return boardSize; }
+    int cell_count() const { return boardSize * boardSize; }
+    // Changes the size and clears the board.
+    void resize(int size);
+
+    void new_game();
+    void clear();
+    bool move(Direction d, MoveTrace *trace = nullptr);
+    bool spawn(int *row = nullptr, int *column = nullptr, int *number = nullptr);
+    bool can_move() const { return kernels[board.wide]->can_move(board); }
+    // The board after a move, without a spawn; equal to `board` when the
+    // move changes nothing.
+    GridBoard moved(Direction d, int64_t *score = nullptr) const;
+
+    int get(int row, int column) const { return board.get(row * boardSize + column); }
+    // Widens the board first when number needs it.
+    void set(int row, int column, int number);
+    int empty_count() const { return empty_count(board); }
+    int empty_count(const GridBoard &b) const;
+    int max_tile() const;
+
+    GridBoard board;
+    int64_t score = 0;
+    GameRandom random;
+
+private:
+    void widen_if_full();
+
+    int boardSize;
+    const GridKernels *kernels[2];      // compact, wide
+};
+
+
+#endif //INC_2048GAME_GRIDENGINE_H
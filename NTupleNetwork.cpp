@@ -0,0 +1,151 @@
+//
+// Created by Rache on 2026/10/17.
+//
+
+#include "NTupleNetwork.h"
+
+
+static Board mirror_rows(Board b) {
+    return ((b & 0x000F000F000F000FULL) << 12) | ((b & 0x00F000F000F000F0ULL) << 4) |
+           ((b & 0x0F000F000F000F00ULL) >> 4) | ((b & 0xF000F000F000F000ULL) >> 12);
+}
+
+static Board mirror_columns(Board b) {
+    return (b << 48) | ((b & 0x00000000FFFF0000ULL) << 16) | ((b & 0x0000FFFF00000000ULL) >> 16) | (b >> 48);
+}
+
+void board_symmetries(Board b, Board out[8]) {
+    Board t = board_transpose(b);
+    out[0] = b;
+    out[1] = mirror_rows(b);
+    out[2] = mirror_columns(b);
+    out[3] = mirror_rows(out[2]);
+    out[4] = t;
+    out[5] = mirror_rows(t);
+    out[6] = mirror_columns(t);
+    out[7] = mirror_rows(out[6]);
+}
+
+NTupleNetwork::NTupleNetwork(const std::vector<std::vector<int>> &tuples) {
+    set_tuples(tuples);
+    storage.assign(weightCount, 0.0f);
+}
+
+void NTupleNetwork::set_tuples(const std::vector<std::vector<int>> &tuples) {
+    tupleCount = 0;
+    weightCount = 0;
+    for (const auto &tuple : tuples) {
+        if (tupleCount == MAX_TUPLES) break;
+        int size = 0;
+        for (int cell : tuple) {
+            if (size == MAX_TUPLE_SIZE) break;
+            cells[tupleCount][size++] = cell;
+        }
+        tupleSize[tupleCount] = size;
+        offsets[tupleCount] = (uint32_t)weightCount;
+        weightCount += (size_t)1 << (4 * size);
+        tupleCount++;
+    }
+}
+
+std::vector<std::vector<int>> NTupleNetwork::patterns(const std::string &name) {
+    if (name == "4tuple") {
+        return {{0, 1, 2, 3}, {4, 5, 6, 7}, {0, 1, 4, 5}, {1, 2, 5, 6}, {5, 6, 9, 10}};
+    }
+    return {{0, 1, 2, 3, 4, 5}, {4, 5, 6, 7, 8, 9}, {0, 1, 2, 4, 5, 6}, {4, 5, 6, 8, 9, 10}};
+}
+
+int NTupleNetwork::features(Board b, uint32_t *indexes) const {
+    Board symmetries[8];
+    board_symmetries(b, symmetries);
+    int count = 0;
+    for (int t = 0; t < tupleCount; ++t) {
+        const int *tupleCells = cells[t];
+        int size = tupleSize[t];
+        for (Board s : symmetries) {
+            uint32_t index = 0;
+            for (int k = 0; k < size; ++k) {
+                index |= (uint32_t)((s >> (4 * tupleCells[k])) & 0xf) << (4 * k);
+            }
+            indexes[count++] = offsets[t] + index;
+        }
+    }
+    return count;
+}
+
+double NTupleNetwork::evaluate(Board b) const {
+    uint32_t indexes[MAX_FEATURES];
+    int count = features(b, indexes);
+    const float *w = weights();
+    float sum = 0;
+    for (int i = 0; i < count; ++i) sum += w[indexes[i]];
+    return sum;
+}
+
+void NTupleNetwork::update(Board b, float delta) {
+    uint32_t indexes[MAX_FEATURES];
+    int count = features(b, indexes);
+    float *w = weights();
+    for (int i = 0; i < count; ++i) w[indexes[i]] += delta;
+}
+
+// What the weight indexes mean: bump the last field when features() or
+// board_symmetries() change.
+static uint64_t weight_layout() {
+    const uint32_t fields[] = {NTupleNetwork::MAX_TUPLES, NTupleNetwork::MAX_TUPLE_SIZE, 4,
+                               (uint32_t)sizeof(float), 1};
+    return TableFile::hash(fields, sizeof(fields));
+}
+
+// Meta data: the tuple count, then per tuple its size and MAX_TUPLE_SIZE
+// cells, unused ones zero.
+bool NTupleNetwork::save(const std::string &path) const {
+    std::vector<int32_t> meta(1 + MAX_TUPLES * (1 + MAX_TUPLE_SIZE), 0);
+    meta[0] = tupleCount;
+    for (int t = 0; t < tupleCount; ++t) {
+        int32_t *entry = &meta[1 + t * (1 + MAX_TUPLE_SIZE)];
+        entry[0] = tupleSize[t];
+        for (int k = 0; k < tupleSize[t]; ++k) entry[1 + k] = cells[t][k];
+    }
+    return TableFile::write(path, TableKind::NTupleWeights, weight_layout(), meta.data(), meta.size() * sizeof(int32_t),
+                            weights(), weightCount * sizeof(float));
+}
+
+bool NTupleNetwork::load(const std::string &path) {
+    std::unique_ptr<TableFile> f(new TableFile);
+    if (!f->open(path, TableKind::NTupleWeights, weight_layout())) return false;
+    if (f->meta_size() != (1 + MAX_TUPLES * (1 + MAX_TUPLE_SIZE)) * sizeof(int32_t)) return false;
+
+    const auto *meta = (const int32_t *)f->meta();
+    int count = meta[0];
+    if (count <= 0 || count > MAX_TUPLES) return false;
+    std::vector<std::vector<int>> tuples;
+    size_t expectedWeights = 0;
+    for (int t = 0; t < count; ++t) {
+        const int32_t *entry = &meta[1 + t * (1 + MAX_TUPLE_SIZE)];
+        if (entry[0] <= 0 || entry[0] > MAX_TUPLE_SIZE) return false;
+        std::vector<int> tuple;
+        for (int k = 0; k < entry[0]; ++k) {
+            if (entry[1 + k] < 0 || entry[1 + k] >= CELL_COUNT) return false;
+            tuple.push_back(entry[1 + k]);
+        }
+        tuples.push_back(tuple);
+        expectedWeights += (size_t)1 << (4 * tuple.size());
+    }
+    if (f->payload_size() != expectedWeights * sizeof(float)) return false;
+
+    set_tuples(tuples);
+    std::vector<float>().swap(storage);
+    file = std::move(f);
+    mapped = (const float *)file->payload();
+    return true;
+}
+
+float *NTupleNetwork::weights() {
+    if (mapped) {
+        storage.assign(mapped, mapped + weightCount);
+        mapped = nullptr;
+        file.reset();
+    }
+    return storage.data();
+}
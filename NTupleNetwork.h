@@ -0,0 +1,72 @@
+//
+// Created by Rache on 2026/10/17.
+//
+
+#ifndef INC_2048GAME_NTUPLENETWORK_H
+#define INC_2048GAME_NTUPLENETWORK_H
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "GameAI.h"
+#include "TableFile.h"
+
+// Value function over afterstates: the sum of one weight per (tuple,
+// symmetry), where a tuple's weight is picked by the tile exponents on its
+// cells. Each tuple is read on all 8 rotations / reflections of the board,
+// so symmetric positions share weights. Weights are picked by nibble, so a
+// board past MAX_TILE_EXPONENT is scored capped, as evaluate_wide does.
+//
+// All weights live in one flat float array, tuple after tuple, so a lookup
+// is an add into a single allocation. A loaded network uses the weights
+// straight from the mapped file and copies them only when asked for
+// writable weights.
+class NTupleNetwork : public BoardEvaluator {
+public:
+    static const int MAX_TUPLES = 8;
+    static const int MAX_TUPLE_SIZE = 6;
+    static const int MAX_FEATURES = MAX_TUPLES * 8;
+
+    // Cells are row-major indexes 0..15.
+    explicit NTupleNetwork(const std::vector<std::vector<int>> &tuples);
+
+    // "6tuple": the usual four 6-tuples (268 MB of weights).
+    // "4tuple": two straight and three square 4-tuples (1.3 MB).
+    static std::vector<std::vector<int>> patterns(const std::string &name);
+
+    double evaluate(Board b) const override;
+
+    // Writes the weight indexes b selects and returns how many there are.
+    int features(Board b, uint32_t *indexes) const;
+    void update(Board b, float delta);
+
+    // Weight files use the TableFile format, with the tuples as meta data.
+    bool save(const std::string &path) const;
+    // Maps a file written by save; the tuples come from the file.
+    bool load(const std::string &path);
+
+    int tuple_count() const { return tupleCount; }
+    size_t weight_count() const { return weightCount; }
+    // The first call on a loaded network copies the weights and unmaps the
+    // file, so make it before other threads use the network.
+    float *weights();
+    const float *weights() const { return mapped ? mapped : storage.data(); }
+
+private:
+    void set_tuples(const std::vector<std::vector<int>> &tuples);
+
+    int tupleCount = 0;
+    int tupleSize[MAX_TUPLES] = {};
+    int cells[MAX_TUPLES][MAX_TUPLE_SIZE] = {};
+    uint32_t offsets[MAX_TUPLES] = {};
+    size_t weightCount = 0;
+    std::vector<float> storage;
+    std::unique_ptr<TableFile> file;
+    const float *mapped = nullptr;
+};
+
+// The 8 rotations and reflections of a board.
+void board_symmetries(Board b, Board out[8]);
+
+
+#endif //INC_2048GAME_NTUPLENETWORK_H
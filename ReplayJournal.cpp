@@ -0,0 +1,331 @@
+//
+// Created by Rache on 2026/10/17.
+//
+
+#include "ReplayJournal.h"
+
+#include <algorithm>
+#include <cstring>
+
+static const char REPLAY_MAGIC[8] = {'2', '0', '4', '8', 'R', 'P', 'L', 0};
+static const char INDEX_MAGIC[8] = {'2', '0', '4', '8', 'I', 'D', 'X', 0};
+static const int HEADER_SIZE = 24;
+static const int INDEX_TRAILER_SIZE = 24;
+
+enum : uint64_t {
+    CODE_MOVE = 0,          // 0
+    CODE_SPAWN = 1,         // 10, lowest bit first
+    CODE_STATE = 3,         // 110
+    CODE_KEYFRAME = 7,      // 1110
+    CODE_END = 15           // 1111
+};
+
+ReplayWriter::~ReplayWriter() {
+    close();
+}
+
+bool ReplayWriter::open(const std::string &path, uint64_t seed) {
+    close();
+    file = fopen(path.c_str(), "wb");
+    if (!file) return false;
+    uint8_t header[HEADER_SIZE] = {};
+    memcpy(header, REPLAY_MAGIC, sizeof(REPLAY_MAGIC));
+    memcpy(header + 8, &REPLAY_VERSION, sizeof(REPLAY_VERSION));
+    memcpy(header + 16, &seed, sizeof(seed));
+    if (fwrite(header, sizeof(header), 1, file) != 1) {
+        close();
+        return false;
+    }
+    shadow = GameEngine(seed);
+    shadow.new_game();
+    moves = 0;
+    bitBuffer = 0;
+    bitCount = 0;
+    bitOffset = 0;
+    keyframes.clear();
+    return true;
+}
+
+void ReplayWriter::put(uint64_t bits, int count) {
+    bitOffset += count;
+    while (count > 0) {
+        int n = count < 32 ? count : 32;
+        bitBuffer |= (bits & (((uint64_t)1 << n) - 1)) << bitCount;
+        bitCount += n;
+        bits >>= n;
+        count -= n;
+        for (; bitCount >= 8; bitCount -= 8, bitBuffer >>= 8) fputc((int)(bitBuffer & 0xff), file);
+    }
+}
+
+void ReplayWriter::put_state(uint64_t code, int codeBits, const GameEngine &game) {
+    put(code, codeBits);
+    put(game.board, 64);
+    put((uint64_t)game.score, 64);
+    put(game.random.state, 64);
+    put(game.high, 64);
+    shadow = game;
+}
+
+void ReplayWriter::record_move(Direction d, const GameEngine &game) {
+    if (!file) return;
+    moves++;
+    GameEngine predicted = shadow;
+    if (predicted.move(d) && predicted.wide_board() == game.wide_board() && predicted.score == game.score &&
+        predicted.random.state == game.random.state) {
+        put(CODE_MOVE | (uint64_t)d << 1, 3);
+        shadow = predicted;
+    } else {
+        record_spawn_move(d, game);
+    }
+    if (keyframeInterval > 0 && moves % keyframeInterval == 0) {
+        keyframes.push_back(moves);
+        keyframes.push_back(bitOffset);
+        put_state(CODE_KEYFRAME, 4, shadow);
+    }
+}
+
+// The spawn did not come from the generator: record it.
+void ReplayWriter::record_spawn_move(Direction d, const GameEngine &game) {
+    int64_t gained = 0;
+    WideBoard moved = wide_move(shadow.wide_board(), d, &gained);
+    Board diff = game.board ^ moved.low;
+    int cell = diff ? __builtin_ctzll(diff) / 4 : 0;
+    int number = (int)((game.board >> (4 * cell)) & 0xf);
+    if (moved != shadow.wide_board() && moved.high == game.high && diff != 0 && (diff >> (4 * cell)) <= 0xf &&
+        (((moved.low | moved.high) >> (4 * cell)) & 0xf) == 0 && (number == 1 || number == 2) &&
+        shadow.score + gained == game.score) {
+        put(CODE_SPAWN | (uint64_t)d << 2 | (uint64_t)cell << 4 | (uint64_t)(number - 1) << 8, 9);
+        shadow.set_wide_board(game.wide_board());
+        shadow.score = game.score;
+        if (shadow.random.state != game.random.state) put_state(CODE_STATE, 3, game);
+    } else {
+        put_state(CODE_STATE, 3, game);
+    }
+}
+
+void ReplayWriter::sync(const GameEngine &game) {
+    if (!file) return;
+    if (game.wide_board() != shadow.wide_board() || game.score != shadow.score ||
+        game.random.state != shadow.random.state) {
+        put_state(CODE_STATE, 3, game);
+    }
+}
+
+void ReplayWriter::flush() {
+    if (file) fflush(file);
+}
+
+void ReplayWriter::close() {
+    if (!file) return;
+    put(CODE_END, 4);
+    if (bitCount > 0) fputc((int)(bitBuffer & 0xff), file);
+    bitBuffer = 0;
+    bitCount = 0;
+    uint64_t trailer[2] = {keyframes.size() / 2, moves};
+    if (!keyframes.empty()) fwrite(keyframes.data(), sizeof(uint64_t), keyframes.size(), file);
+    fwrite(trailer, sizeof(trailer), 1, file);
+    fwrite(INDEX_MAGIC, sizeof(INDEX_MAGIC), 1, file);
+    fclose(file);
+    file = nullptr;
+}
+
+bool ReplayReader::open(const std::string &path) {
+    data.clear();
+    keyframes.clear();
+    FILE *f = fopen(path.c_str(), "rb");
+    if (!f) return false;
+    uint8_t header[HEADER_SIZE];
+    bool ok = fread(header, sizeof(header), 1, f) == 1;
+    if (ok) memcpy(&version, header + 8, sizeof(version));
+    ok = ok && memcmp(header, REPLAY_MAGIC, sizeof(REPLAY_MAGIC)) == 0 && version >= 1 && version <= REPLAY_VERSION;
+    if (ok) {
+        memcpy(&startSeed, header + 16, sizeof(startSeed));
+        uint8_t buffer[1 << 16];
+        for (size_t n; (n = fread(buffer, 1, sizeof(buffer), f)) > 0; ) data.insert(data.end(), buffer, buffer + n);
+    }
+    fclose(f);
+    if (!ok) return false;
+
+    streamBits = data.size() * 8;
+    data.resize(data.size() + 8, 0);
+    if (!read_index()) build_index();
+    start_stream();
+    return true;
+}
+
+bool ReplayReader::read_index() {
+    size_t size = streamBits / 8;
+    if (version < 2 || size < INDEX_TRAILER_SIZE) return false;
+    const uint8_t *trailer = data.data() + size - INDEX_TRAILER_SIZE;
+    if (memcmp(trailer + 16, INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0) return false;
+    uint64_t count, total;
+    memcpy(&count, trailer, sizeof(count));
+    memcpy(&total, trailer + 8, sizeof(total));
+    if (count > (size - INDEX_TRAILER_SIZE) / sizeof(Keyframe)) return false;
+
+    size_t indexStart = size - INDEX_TRAILER_SIZE - count * sizeof(Keyframe);
+    keyframes.resize(count);
+    if (count > 0) memcpy(keyframes.data(), data.data() + indexStart, count * sizeof(Keyframe));
+    for (const Keyframe &k : keyframes) {
+        if (k.bitOffset >= indexStart * 8) {
+            keyframes.clear();
+            return false;
+        }
+    }
+    streamBits = indexStart * 8;
+    totalMoves = total;
+    return true;
+}
+
+// Record lengths do not depend on the game, so the index needs no replay.
+void ReplayReader::build_index() {
+    keyframes.clear();
+    bitPosition = 0;
+    moves = 0;
+    for (Record r; (r = read_code()) != Record::End; ) {
+        size_t skip = r == Record::Move ? 2 : r == Record::SpawnMove ? 7 : state_bits();
+        if (!has_bits(skip)) break;
+        if (r == Record::Keyframe) keyframes.push_back({moves, bitPosition - 4});
+        if (r == Record::Move || r == Record::SpawnMove) moves++;
+        bitPosition += skip;
+    }
+    totalMoves = moves;
+}
+
+// Reads the 8 bytes holding the bits at once; the padding after the data
+// keeps that in bounds.
+uint64_t ReplayReader::peek(int count) const {
+    uint64_t word;
+    memcpy(&word, data.data() + (bitPosition >> 3), sizeof(word));
+    return (word >> (bitPosition & 7)) & (((uint64_t)1 << count) - 1);
+}
+
+uint64_t ReplayReader::get(int count) {
+    if (count > 32) {
+        uint64_t low = get(32);
+        return low | get(count - 32) << 32;
+    }
+    uint64_t value = peek(count);
+    bitPosition += count;
+    return value;
+}
+
+ReplayReader::Record ReplayReader::read_code() {
+    size_t left = streamBits - bitPosition;
+    uint64_t bits = left == 0 ? 0 : peek(left < 4 ? (int)left : 4);
+    for (int i = 0; i < 3; ++i) {
+        if ((size_t)i >= left) break;
+        if (!((bits >> i) & 1)) {
+            bitPosition += i + 1;
+            return (Record)i;
+        }
+    }
+    if (left < 3) {
+        bitPosition = streamBits;
+        return Record::End;
+    }
+    if (version < 2) {
+        bitPosition += 3;
+        ended = true;
+        return Record::End;
+    }
+    if (left < 4) {
+        bitPosition = streamBits;
+        return Record::End;
+    }
+    bitPosition += 4;
+    if (!((bits >> 3) & 1)) return Record::Keyframe;
+    ended = true;
+    return Record::End;
+}
+
+void ReplayReader::start_stream() {
+    bitPosition = 0;
+    moves = 0;
+    failed = false;
+    explicitSpawns = 0;
+    jumpCount = 0;
+    keyframeMismatches = 0;
+    ended = false;
+}
+
+void ReplayReader::start(GameEngine &game) {
+    game = GameEngine(startSeed);
+    game.new_game();
+    start_stream();
+}
+
+bool ReplayReader::next(GameEngine &game) {
+    Record r = read_code();
+    switch (r) {
+        case Record::Move: {
+            if (!has_bits(2)) return false;
+            auto d = (Direction)get(2);
+            moves++;
+            failed = !game.move(d);
+            return !failed;
+        }
+        case Record::SpawnMove: {
+            if (!has_bits(7)) return false;
+            auto d = (Direction)get(2);
+            int cell = (int)get(4);
+            int number = (int)get(1) + 1;
+            moves++;
+            int64_t gained = 0;
+            WideBoard moved = wide_move(game.wide_board(), d, &gained);
+            failed = moved == game.wide_board() || (((moved.low | moved.high) >> (4 * cell)) & 0xf) != 0;
+            if (failed) return false;
+            game.set_wide_board({moved.low | (Board)number << (4 * cell), moved.high});
+            game.score += gained;
+            explicitSpawns++;
+            return true;
+        }
+        case Record::State:
+        case Record::Keyframe: {
+            if (!has_bits(state_bits())) return false;
+            Board board = get(64);
+            auto score = (int64_t)get(64);
+            uint64_t random = get(64);
+            Board high = version >= 3 ? get(64) : 0;
+            if (r == Record::State) {
+                jumpCount++;
+            } else if (WideBoard{board, high} != game.wide_board() || score != game.score ||
+                       random != game.random.state) {
+                keyframeMismatches++;
+            }
+            game.set_wide_board({board, high});
+            game.score = score;
+            game.random.state = random;
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+bool ReplayReader::seek(GameEngine &game, uint64_t move) {
+    if (move > totalMoves) return false;
+    auto k = std::upper_bound(keyframes.begin(), keyframes.end(), move,
+                              [](uint64_t m, const Keyframe &keyframe) { return m < keyframe.move; });
+    if (k == keyframes.begin()) {
+        start(game);
+    } else {
+        --k;
+        bitPosition = k->bitOffset;
+        moves = k->move;
+        failed = false;
+        if (!next(game)) return false;
+    }
+    while (moves < move) {
+        if (!next(game)) return false;
+    }
+    // Take the jumps recorded right after the move too.
+    for (size_t position = bitPosition; ; position = bitPosition) {
+        Record r = read_code();
+        bitPosition = position;
+        if (r != Record::State && r != Record::Keyframe) break;
+        next(game);
+    }
+    return true;
+}
@@ -0,0 +1,149 @@
+//
+// Created by Rache on 2026/10/17.
+//
+
+#ifndef INC_2048GAME_REPLAYJOURNAL_H
+#define INC_2048GAME_REPLAYJOURNAL_H
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "GameEngine.h"
+
+// Append-only record of one game. A 24-byte header holds the seed the game
+// started from (GameEngine(seed).new_game() gives the first board), then a
+// bit stream of records, lowest bit first:
+//
+//   0 dd                       move d; the spawn is the one the game's
+//                              random generator makes
+//   10 dd cccc v               move d, then a 2 (v = 0) or 4 (v = 1) on cell
+//                              c; the generator is not used
+//   110 board score random high
+//                              the game jumped to this state (undo, run_cmd
+//                              edits, ...); four 64-bit fields, high being
+//                              GameEngine::high
+//   1110 board score random high
+//                              keyframe: the state at this point, written
+//                              every keyframeInterval moves
+//   1111                       end of the journal
+//
+// After the end record, close() writes an index of the keyframes so a
+// reader can seek without scanning: per keyframe its move number and bit
+// offset (two uint64), then the keyframe count, the move count and the
+// magic "2048IDX" (three 8-byte fields). A journal cut short has no
+// index; the reader then builds it with one pass over the records.
+//
+// A normal game costs 3 bits per move, so a million moves fit in 375 KB;
+// keyframes every 4096 moves add under 2 percent. Version 1 journals have
+// no keyframes, and 111 ends them; states in version 1 and 2 journals have
+// no high field.
+static const uint32_t REPLAY_VERSION = 3;
+
+// Mirrors the game it records, so it can tell which record reproduces
+// each change. Only whole bytes reach the file before close(); a journal
+// cut short by a crash reads as if it ended there.
+class ReplayWriter {
+public:
+    ReplayWriter() = default;
+    ~ReplayWriter();
+    ReplayWriter(const ReplayWriter &) = delete;
+    ReplayWriter &operator=(const ReplayWriter &) = delete;
+
+    // `seed` is the random state right before new_game().
+    bool open(const std::string &path, uint64_t seed);
+    bool is_open() const { return file != nullptr; }
+    // Call after game.move(d) succeeded.
+    void record_move(Direction d, const GameEngine &game);
+    // Call after the game changed in any other way; records nothing when
+    // it did not change.
+    void sync(const GameEngine &game);
+    void flush();
+    void close();
+
+    uint64_t move_count() const { return moves; }
+
+    uint64_t keyframeInterval = 4096;
+
+private:
+    void put(uint64_t bits, int count);
+    void put_state(uint64_t code, int codeBits, const GameEngine &game);
+    void record_spawn_move(Direction d, const GameEngine &game);
+
+    FILE *file = nullptr;
+    GameEngine shadow;
+    uint64_t moves = 0;
+    uint64_t bitBuffer = 0;
+    int bitCount = 0;
+    uint64_t bitOffset = 0;
+    std::vector<uint64_t> keyframes;    // move number, bit offset, ...
+};
+
+class ReplayReader {
+public:
+    // Reads the whole journal and its keyframe index; false when it is
+    // missing or not a journal.
+    bool open(const std::string &path);
+    uint64_t seed() const { return startSeed; }
+    // Moves in the whole journal.
+    uint64_t total_moves() const { return totalMoves; }
+
+    // Starts `game` at the first board of the journal.
+    void start(GameEngine &game);
+    // Applies the next record to `game`. Returns false at the end of the
+    // journal or when a record does not apply (a corrupt journal), which
+    // error() tells apart.
+    bool next(GameEngine &game);
+    bool error() const { return failed; }
+    // Moves applied so far.
+    uint64_t move_count() const { return moves; }
+
+    // What playing from start() met so far, for telling a game that only
+    // used the seed's spawns from an edited one: moves whose spawn was not
+    // the generator's, jumps to another state, keyframes that disagreed
+    // with the replayed state, and whether the end record was reached
+    // (false for a journal cut short).
+    uint64_t explicit_spawns() const { return explicitSpawns; }
+    uint64_t jumps() const { return jumpCount; }
+    uint64_t keyframe_mismatches() const { return keyframeMismatches; }
+    bool complete() const { return ended; }
+
+    // Sets `game` to the state after `move` moves (and any jumps recorded
+    // right after it), replaying from the nearest keyframe at or before
+    // it. Returns false when the journal is shorter.
+    bool seek(GameEngine &game, uint64_t move);
+
+private:
+    struct Keyframe {
+        uint64_t move;
+        uint64_t bitOffset;
+    };
+
+    enum class Record { Move, SpawnMove, State, Keyframe, End };
+
+    uint64_t peek(int count) const;
+    uint64_t get(int count);
+    bool has_bits(size_t count) const { return bitPosition + count <= streamBits; }
+    // Reads the next record's code; End also for a truncated journal.
+    Record read_code();
+    bool read_index();
+    void build_index();
+    void start_stream();
+    size_t state_bits() const { return version >= 3 ? 256 : 192; }
+
+    std::vector<uint8_t> data;         // 8 zero bytes past the file, for get()
+    size_t streamBits = 0;
+    uint32_t version = 0;
+    uint64_t startSeed = 0;
+    std::vector<Keyframe> keyframes;
+    uint64_t totalMoves = 0;
+    size_t bitPosition = 0;
+    uint64_t moves = 0;
+    bool failed = false;
+    uint64_t explicitSpawns = 0;
+    uint64_t jumpCount = 0;
+    uint64_t keyframeMismatches = 0;
+    bool ended = false;
+};
+
+
+#endif //INC_2048GAME_REPLAYJOURNAL_H
@@ -0,0 +1,39 @@
+//
+// Created by Rache on 2026/10/17.
+//
+
+#include <QHBoxLayout>
+#include "ReplayScrubber.h"
+
+ReplayScrubber::ReplayScrubber() {
+    slider = new QSlider(Qt::Horizontal);
+    moveLabel = new QLabel("0/0");
+    exitButton = new QPushButton("退出回放");
+
+    moveLabel->setStyleSheet("font-family: \"Segoe UI\"; font-size: 12px; color: #776e65; font-weight: bold");
+    moveLabel->setMinimumWidth(90);
+    exitButton->setStyleSheet("font-family: \"Microsoft YaHei\"; font-size: 12px; color: #f9f6f2; font-weight: bold; background-color: #8f7a66; border-radius: 4px;");
+    exitButton->setFixedSize(70, 24);
+
+    auto layout = new QHBoxLayout;
+    layout->addWidget(slider);
+    layout->addWidget(moveLabel);
+    layout->addWidget(exitButton);
+    layout->setContentsMargins(0, 0, 0, 0);
+    setLayout(layout);
+
+    connect(slider, SIGNAL(valueChanged(int)), this, SLOT(slider_valueChanged(int)));
+}
+
+void ReplayScrubber::set_total_moves(int total) {
+    slider->blockSignals(true);
+    slider->setRange(0, total);
+    slider->setValue(0);
+    slider->blockSignals(false);
+    moveLabel->setText("0/" + QString::number(total));
+}
+
+void ReplayScrubber::slider_valueChanged(int value) {
+    moveLabel->setText(QString::number(value) + "/" + QString::number(slider->maximum()));
+    emit position_changed(value);
+}
@@ -0,0 +1,37 @@
+//
+// Created by Rache on 2026/10/17.
+//
+
+#ifndef INC_2048GAME_REPLAYSCRUBBER_H
+#define INC_2048GAME_REPLAYSCRUBBER_H
+
+#include <QWidget>
+#include <QSlider>
+#include <QLabel>
+#include <QPushButton>
+
+// A slider over the moves of an opened replay. It only reports positions;
+// MainWindow seeks the journal and draws the board.
+class ReplayScrubber : public QWidget{
+    Q_OBJECT
+public:
+    ReplayScrubber();
+
+    void set_total_moves(int total);
+    int position() const { return slider->value(); }
+
+    QPushButton *exitButton;
+
+signals:
+    void position_changed(int move);
+
+private:
+    QSlider *slider;
+    QLabel *moveLabel;
+
+private slots:
+    void slider_valueChanged(int value);
+};
+
+
+#endif //INC_2048GAME_REPLAYSCRUBBER_H
@@ -0,0 +1,138 @@
+//
+// Created by Rache on 2026/10/17.
+//
+
+#include "SaveFile.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include "TableFile.h"
+
+static const char SAVE_MAGIC[8] = {'2', '0', '4', '8', 'S', 'A', 'V', 0};
+static const uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+static const size_t SAVE_HEADER_V1_SIZE = offsetof(SaveFileHeader, high);
+
+static_assert(sizeof(SaveFileHeader) == 72, "the save header is part of the file format");
+static_assert(SAVE_HEADER_V1_SIZE == 64, "version 1 saves end their header before `high`");
+
+uint32_t crc32(const void *data, size_t size, uint32_t crc) {
+    static const struct CrcTable {
+        uint32_t entries[256];
+        CrcTable() : entries() {
+            for (uint32_t i = 0; i < 256; ++i) {
+                uint32_t c = i;
+                for (int k = 0; k < 8; ++k) c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                entries[i] = c;
+            }
+        }
+    } table;
+    const auto *bytes = (const uint8_t *)data;
+    crc = ~crc;
+    for (size_t i = 0; i < size; ++i) crc = table.entries[(crc ^ bytes[i]) & 0xff] ^ (crc >> 8);
+    return ~crc;
+}
+
+// Covers the first `headerSize` bytes of the header, so a version 1 save
+// checks out against the bytes it was written with.
+static uint32_t save_crc(const SaveFileHeader &header, size_t headerSize, const uint8_t *history, size_t historySize) {
+    SaveFileHeader h = header;
+    h.crc = 0;
+    return crc32(history, historySize, crc32(&h, headerSize));
+}
+
+static SaveFormat parse_legacy(const uint8_t *data, size_t size, SavedGame &game, UndoHistory &history) {
+    if (size != LEGACY_SAVE_SIZE) return SaveFormat::Invalid;
+    int32_t score, undoCount, numbers[4][4];
+    memcpy(&score, data, sizeof(score));
+    memcpy(&undoCount, data + 4, sizeof(undoCount));
+    memcpy(numbers, data + 8, sizeof(numbers));
+    char undoLock = (char)data[8 + sizeof(numbers)];
+    if (score < 0 || undoCount < 0 || (undoLock != 0 && undoLock != 1)) return SaveFormat::Invalid;
+
+    WideBoard board;
+    for (int i = 0; i < 4; ++i) {
+        for (int j = 0; j < 4; ++j) {
+            int number = numbers[i][j];
+            if (number < 0 || number > MAX_LEGACY_TILE_EXPONENT) return SaveFormat::Invalid;
+            board = wide_set(board, i, j, number);
+        }
+    }
+    game.board = board.low;
+    game.high = board.high;
+    game.score = score;
+    game.undoCount = undoCount;
+    game.undoLock = undoLock != 0;
+    history.reset({board.low, score, board.high});
+    return SaveFormat::Legacy;
+}
+
+SaveFormat parse_saved_game(const uint8_t *data, size_t size, SavedGame &game, UndoHistory &history) {
+    if (size < SAVE_HEADER_V1_SIZE || memcmp(data, SAVE_MAGIC, sizeof(SAVE_MAGIC)) != 0) {
+        return parse_legacy(data, size, game, history);
+    }
+    // A version 1 header is a prefix of the current one; `high` stays 0.
+    SaveFileHeader header{};
+    memcpy(&header, data, SAVE_HEADER_V1_SIZE);
+    bool v1 = header.version == 1;
+    size_t headerSize = v1 ? SAVE_HEADER_V1_SIZE : sizeof(header);
+    if (!v1 && size >= sizeof(header)) memcpy(&header, data, sizeof(header));
+    const uint8_t *historyData = data + headerSize;
+    bool ok = (v1 || header.version == SAVE_FILE_VERSION) &&
+              header.byteOrder == BYTE_ORDER_MARK &&
+              header.headerSize == headerSize && size >= headerSize &&
+              header.historySize == size - headerSize &&
+              header.crc == save_crc(header, headerSize, historyData, header.historySize) &&
+              header.score >= 0 && header.undoCount >= 0 && (header.flags & ~SAVE_UNDO_LOCK) == 0;
+    if (!ok) return SaveFormat::Invalid;
+
+    GameState state{header.board, header.score, header.high};
+    UndoHistory loaded;
+    if (header.historySize == 0) {
+        loaded.reset(state);
+    } else if (!loaded.deserialize(historyData, header.historySize, !v1) || loaded.current_state() != state) {
+        return SaveFormat::Invalid;
+    }
+
+    game.board = header.board;
+    game.high = header.high;
+    game.score = header.score;
+    game.randomState = header.randomState;
+    game.undoCount = header.undoCount;
+    game.undoLock = (header.flags & SAVE_UNDO_LOCK) != 0;
+    history = std::move(loaded);
+    return SaveFormat::Current;
+}
+
+SaveFormat read_saved_game(const std::string &path, SavedGame &game, UndoHistory &history) {
+    MappedFile file;
+    if (!file.open(path)) return SaveFormat::Invalid;
+    return parse_saved_game(file.data(), file.size(), game, history);
+}
+
+void encode_saved_game(const SavedGame &game, const UndoHistory &history, std::vector<uint8_t> &out) {
+    out.assign(sizeof(SaveFileHeader), 0);
+    if (!history.empty()) history.serialize(out);
+
+    SaveFileHeader header{};
+    memcpy(header.magic, SAVE_MAGIC, sizeof(SAVE_MAGIC));
+    header.version = SAVE_FILE_VERSION;
+    header.byteOrder = BYTE_ORDER_MARK;
+    header.headerSize = sizeof(header);
+    header.flags = game.undoLock ? SAVE_UNDO_LOCK : 0;
+    header.board = game.board;
+    header.high = game.high;
+    header.score = game.score;
+    header.randomState = game.randomState;
+    header.undoCount = game.undoCount;
+    header.historySize = (uint32_t)(out.size() - sizeof(header));
+    header.crc = save_crc(header, sizeof(header), out.data() + sizeof(header), header.historySize);
+    memcpy(out.data(), &header, sizeof(header));
+}
+
+bool write_saved_game(const std::string &path, const SavedGame &game, const UndoHistory &history) {
+    std::vector<uint8_t> bytes;
+    encode_saved_game(game, history, bytes);
+    return replace_file(path, {{bytes.data(), bytes.size()}});
+}
@@ -0,0 +1,83 @@
+//
+// Created by Rache on 2026/10/17.
+//
+
+#ifndef INC_2048GAME_SAVEFILE_H
+#define INC_2048GAME_SAVEFILE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "GameEngine.h"
+#include "UndoHistory.h"
+
+// Saved game (.2048game):
+//
+//   header    72 bytes, see SaveFileHeader
+//   history   the undo tree, UndoHistory::serialize()
+//
+// The whole file is covered by a CRC-32, so a truncated or damaged save is
+// rejected instead of loading garbage. Like table files, saves are in the
+// writer's byte order and a mismatching byte order mark rejects them.
+//
+// Saves made before the header existed are 73 bytes of native ints: score,
+// undo count, the 4x4 tile exponents, then a char undo lock. They are still
+// read, but carry no undo history or random state. Their tiles go up to
+// 131072, past what a Board holds.
+//
+// Version 1 saves have the 64-byte header without `high`, and history
+// keyframes without it either; they are still read, as boards with no tile
+// past 32768.
+static const uint32_t SAVE_FILE_VERSION = 2;
+static const size_t LEGACY_SAVE_SIZE = 4 + 4 + 4 * 16 + 1;
+static const int MAX_LEGACY_TILE_EXPONENT = 17;
+
+static const uint32_t SAVE_UNDO_LOCK = 1;   // SaveFileHeader::flags
+
+struct SaveFileHeader {
+    char magic[8];              // "2048SAV" and a NUL
+    uint32_t version;           // SAVE_FILE_VERSION
+    uint32_t byteOrder;         // 0x01020304 as written by the producing machine
+    uint32_t headerSize;        // sizeof(SaveFileHeader)
+    uint32_t flags;             // SAVE_UNDO_LOCK
+    uint64_t board;
+    int64_t score;
+    uint64_t randomState;
+    int32_t undoCount;
+    uint32_t historySize;       // bytes after the header
+    uint32_t crc;               // CRC-32 of the header with crc = 0, then the history
+    uint32_t reserved;
+    uint64_t high;              // GameEngine::high, since version 2
+};
+
+enum class SaveFormat {
+    Invalid,
+    Legacy,
+    Current
+};
+
+struct SavedGame {
+    Board board = 0;
+    Board high = 0;             // GameEngine::high
+    int64_t score = 0;
+    uint64_t randomState = 0;   // not set by legacy saves
+    int32_t undoCount = 0;
+    bool undoLock = false;
+};
+
+// Checks a whole save held in memory and decodes it. On success `history`
+// gets the saved tree, or just the saved state for a legacy save; on
+// failure neither `game` nor `history` is touched.
+SaveFormat parse_saved_game(const uint8_t *data, size_t size, SavedGame &game, UndoHistory &history);
+// Maps the file and parses it in place.
+SaveFormat read_saved_game(const std::string &path, SavedGame &game, UndoHistory &history);
+
+// The current format, with an empty history standing for just the state.
+void encode_saved_game(const SavedGame &game, const UndoHistory &history, std::vector<uint8_t> &out);
+// Goes through replace_file, so an interrupted save keeps the old file.
+bool write_saved_game(const std::string &path, const SavedGame &game, const UndoHistory &history);
+
+uint32_t crc32(const void *data, size_t size, uint32_t crc = 0);
+
+
+#endif //INC_2048GAME_SAVEFILE_H
@@ -0,0 +1,271 @@
+//
+// Created by Rache on 2026/10/17.
+//
+// Reads every .2048game save in a directory on every core, legacy and
+// current format alike, with the parser MainWindow::read_file uses, and
+// prints the score distribution, the max tile and empty cell histograms
+// and how many saves are dead positions.
+//
+// usage: 2048Saves [-t threads] [-o dir] dir
+//
+// -o writes every readable save to the given directory in the current
+// format; it may be the input directory, which converts the legacy saves in
+// place. Legacy saves have no random state, so they get one hashed from
+// their bytes.
+//
+// Workers take the directory entries one at a time, so memory does not
+// grow with the number of saves.
+//
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cinttypes>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <algorithm>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#endif
+
+#include "SaveFile.h"
+#include "TableFile.h"
+#include "ThreadPool.h"
+
+struct SaveToolOptions {
+    int threads = 0;
+    std::string input;
+    std::string output;
+};
+
+// The file names in one directory, read one at a time.
+class DirectoryReader {
+public:
+    explicit DirectoryReader(const std::string &path) {
+#ifdef _WIN32
+        WIN32_FIND_DATAA data;
+        find = FindFirstFileA((path + "\\*").c_str(), &data);
+        if (find != INVALID_HANDLE_VALUE) first = data.cFileName;
+#else
+        directory = opendir(path.c_str());
+#endif
+    }
+
+    ~DirectoryReader() {
+#ifdef _WIN32
+        if (find != INVALID_HANDLE_VALUE) FindClose(find);
+#else
+        if (directory) closedir(directory);
+#endif
+    }
+
+    DirectoryReader(const DirectoryReader &) = delete;
+    DirectoryReader &operator=(const DirectoryReader &) = delete;
+
+#ifdef _WIN32
+    bool is_open() const { return find != INVALID_HANDLE_VALUE; }
+
+    bool next(std::string &name) {
+        if (!first.empty()) {
+            name.swap(first);
+            first.clear();
+            return true;
+        }
+        WIN32_FIND_DATAA data;
+        if (!FindNextFileA(find, &data)) return false;
+        name = data.cFileName;
+        return true;
+    }
+#else
+    bool is_open() const { return directory != nullptr; }
+
+    bool next(std::string &name) {
+        struct dirent *entry = readdir(directory);
+        if (!entry) return false;
+        name = entry->d_name;
+        return true;
+    }
+#endif
+
+private:
+#ifdef _WIN32
+    HANDLE find;
+    std::string first;
+#else
+    DIR *directory;
+#endif
+};
+
+static bool is_save_name(const std::string &name) {
+    static const char EXTENSION[] = ".2048game";
+    size_t length = sizeof(EXTENSION) - 1;
+    return name.size() > length && name.compare(name.size() - length, length, EXTENSION) == 0;
+}
+
+struct SaveStats {
+    static const int SCORE_OCTAVES = 40;
+
+    uint64_t files = 0;
+    uint64_t legacy = 0;
+    uint64_t current = 0;
+    uint64_t invalid = 0;
+    uint64_t converted = 0;
+    uint64_t convertFailures = 0;
+    uint64_t dead = 0;
+    uint64_t historyStates = 0;
+    double scoreSum = 0;
+    int64_t maxScore = 0;
+    uint64_t scoreOctaves[SCORE_OCTAVES] = {};
+    uint64_t maxTiles[MAX_WIDE_TILE_EXPONENT + 1] = {};
+    uint64_t emptyCells[CELL_COUNT + 1] = {};
+
+    void add_game(const SavedGame &game, const UndoHistory &history) {
+        scoreSum += (double)game.score;
+        maxScore = std::max(maxScore, game.score);
+        int octave = 0;
+        while (octave + 1 < SCORE_OCTAVES && game.score >> (octave + 1) != 0) octave++;
+        scoreOctaves[game.score == 0 ? 0 : octave]++;
+        WideBoard board{game.board, game.high};
+        emptyCells[wide_empty_count(board)]++;
+        maxTiles[wide_max_tile(board)]++;
+        dead += !wide_can_move(board);
+        historyStates += history.size();
+    }
+
+    void merge(const SaveStats &other) {
+        files += other.files;
+        legacy += other.legacy;
+        current += other.current;
+        invalid += other.invalid;
+        converted += other.converted;
+        convertFailures += other.convertFailures;
+        dead += other.dead;
+        historyStates += other.historyStates;
+        scoreSum += other.scoreSum;
+        maxScore = std::max(maxScore, other.maxScore);
+        for (int i = 0; i < SCORE_OCTAVES; ++i) scoreOctaves[i] += other.scoreOctaves[i];
+        for (int i = 0; i <= MAX_WIDE_TILE_EXPONENT; ++i) maxTiles[i] += other.maxTiles[i];
+        for (int i = 0; i <= CELL_COUNT; ++i) emptyCells[i] += other.emptyCells[i];
+    }
+};
+
+static void process_save(const SaveToolOptions &options, const std::string &name, SaveStats &stats) {
+    std::string path = options.input + "/" + name;
+    SavedGame game;
+    UndoHistory history;
+    SaveFormat format;
+    {
+        MappedFile file;
+        format = file.open(path) ? parse_saved_game(file.data(), file.size(), game, history) : SaveFormat::Invalid;
+        if (format == SaveFormat::Legacy) game.randomState = TableFile::hash(file.data(), file.size());
+    }
+    stats.files++;
+    if (format == SaveFormat::Invalid) {
+        stats.invalid++;
+        fprintf(stderr, "cannot read %s\n", path.c_str());
+        return;
+    }
+    (format == SaveFormat::Legacy ? stats.legacy : stats.current)++;
+    stats.add_game(game, history);
+
+    if (options.output.empty() || (format == SaveFormat::Current && options.output == options.input)) return;
+    if (write_saved_game(options.output + "/" + name, game, history)) {
+        stats.converted++;
+    } else {
+        stats.convertFailures++;
+        fprintf(stderr, "cannot write %s/%s\n", options.output.c_str(), name.c_str());
+    }
+}
+
+static void print_report(const SaveStats &stats, double seconds, int threads) {
+    uint64_t games = stats.legacy + stats.current;
+    printf("saves        %" PRIu64 " in %.2f s on %d threads: %" PRIu64 " current, %" PRIu64 " legacy, "
+           "%" PRIu64 " unreadable\n", stats.files, seconds, threads, stats.current, stats.legacy, stats.invalid);
+    if (stats.converted + stats.convertFailures > 0) {
+        printf("converted    %" PRIu64 ", %" PRIu64 " failed\n", stats.converted, stats.convertFailures);
+    }
+    if (games == 0) return;
+    printf("score        mean %.1f  max %" PRId64 "\n", stats.scoreSum / games, stats.maxScore);
+    printf("dead         %" PRIu64 "  %6.2f%%\n", stats.dead, 100.0 * stats.dead / games);
+    printf("history      %.1f states per save\n", (double)stats.historyStates / games);
+
+    printf("\nscore distribution\n");
+    for (int octave = 0; octave < SaveStats::SCORE_OCTAVES; ++octave) {
+        uint64_t count = stats.scoreOctaves[octave];
+        if (count == 0) continue;
+        printf("  [%9lld, %9lld)  %10" PRIu64 "  %6.2f%%\n", octave == 0 ? 0LL : 1LL << octave, 1LL << (octave + 1),
+               count, 100.0 * count / games);
+    }
+
+    printf("\nmax tile\n");
+    for (int tile = 0; tile <= MAX_WIDE_TILE_EXPONENT; ++tile) {
+        if (stats.maxTiles[tile] == 0) continue;
+        printf("  %6" PRIu64 "  %10" PRIu64 "  %6.2f%%\n", tile == 0 ? 0 : (uint64_t)1 << tile, stats.maxTiles[tile],
+               100.0 * stats.maxTiles[tile] / games);
+    }
+
+    printf("\nempty cells\n");
+    for (int empty = 0; empty <= CELL_COUNT; ++empty) {
+        if (stats.emptyCells[empty] == 0) continue;
+        printf("  %6d  %10" PRIu64 "  %6.2f%%\n", empty, stats.emptyCells[empty], 100.0 * stats.emptyCells[empty] / games);
+    }
+}
+
+static bool parse_options(int argc, char *argv[], SaveToolOptions &options) {
+    for (int i = 1; i < argc; ++i) {
+        if (argv[i][0] != '-') {
+            if (!options.input.empty()) return false;
+            options.input = argv[i];
+            continue;
+        }
+        if (i + 1 >= argc) return false;
+        const char *value = argv[++i];
+        if (strcmp(argv[i - 1], "-t") == 0) options.threads = atoi(value);
+        else if (strcmp(argv[i - 1], "-o") == 0) options.output = value;
+        else return false;
+    }
+    return !options.input.empty();
+}
+
+int main(int argc, char *argv[]) {
+    SaveToolOptions options;
+    if (!parse_options(argc, argv, options)) {
+        fprintf(stderr, "usage: %s [-t threads] [-o dir] dir\n", argv[0]);
+        return 1;
+    }
+    DirectoryReader directory(options.input);
+    if (!directory.is_open()) {
+        fprintf(stderr, "cannot read %s\n", options.input.c_str());
+        return 1;
+    }
+
+    ThreadPool pool(options.threads);
+    SaveStats total;
+    std::mutex directoryMutex, totalMutex;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < pool.size(); ++t) {
+        pool.submit([&] {
+            SaveStats stats;
+            std::string name;
+            for (;;) {
+                {
+                    std::lock_guard<std::mutex> lock(directoryMutex);
+                    if (!directory.next(name)) break;
+                }
+                if (is_save_name(name)) process_save(options, name, stats);
+            }
+            std::lock_guard<std::mutex> lock(totalMutex);
+            total.merge(stats);
+        });
+    }
+    pool.wait();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    print_report(total, seconds, pool.size());
+    return total.invalid + total.convertFailures == 0 ? 0 : 2;
+}
@@ -0,0 +1,356 @@
+//
+// Created by Rache on 2026/10/17.
+//
+// Plays complete games headlessly on every core and prints the score
+// distribution, the max tile histogram, moves per game and games per second.
+//
+// usage: 2048Sim [-n games] [-p random|greedy|expectimax|ntuple] [-d depth]
+//                [-t threads] [-s seed] [-w weights] [-R rowtables] [-j dir]
+//                [-b size]
+//
+// With -w the expectimax policy evaluates its leaves with the n-tuple
+// network instead of the row heuristic; the ntuple policy needs -w.
+// -R maps the row tables from a file, writing it first if it is missing or
+// stale; the weights are always mapped. Processes mapping the same files
+// share one copy of them in memory.
+// -j writes a replay journal of every game to dir/game<i>.2048replay.
+// -b plays on a size x size board, 3 to 8, with GridGame. Only the random
+// and greedy policies play sizes other than 4, and without journals.
+//
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <chrono>
+#include <mutex>
+#include <memory>
+#include <string>
+#include <algorithm>
+
+#include "GameAI.h"
+#include "GridEngine.h"
+#include "NTupleNetwork.h"
+#include "ReplayJournal.h"
+#include "ThreadPool.h"
+
+struct SimOptions {
+    uint64_t games = 10000;
+    std::string policy = "random";
+    int depth = 2;
+    int threads = 0;
+    uint64_t seed = 1;
+    std::string weights;
+    std::string rowTables;
+    std::string journalDir;
+    int size = BOARD_SIZE;
+    const NTupleNetwork *network = nullptr;
+};
+
+class Policy {
+public:
+    virtual ~Policy() = default;
+    // Only called when at least one move changes the board.
+    virtual Direction choose(WideBoard b, GameRandom &random) = 0;
+};
+
+class RandomPolicy : public Policy {
+public:
+    Direction choose(WideBoard b, GameRandom &random) override {
+        Direction legal[4];
+        int count = 0;
+        int moves = wide_legal_moves(b);
+        for (int d = 0; d < 4; ++d) {
+            if (moves >> d & 1) legal[count++] = (Direction)d;
+        }
+        return legal[random.bounded(count)];
+    }
+};
+
+// Takes the move that scores most, then the one that leaves most empty cells.
+class GreedyPolicy : public Policy {
+public:
+    Direction choose(WideBoard b, GameRandom &random) override {
+        Direction best = Direction::Up;
+        int64_t bestKey = -1;
+        for (int d = 0; d < 4; ++d) {
+            int64_t gained = 0;
+            WideBoard next = wide_move(b, (Direction)d, &gained);
+            if (next == b) continue;
+            int64_t key = gained * 32 + wide_empty_count(next) * 2 + (random.next() & 1);
+            if (key > bestKey) {
+                bestKey = key;
+                best = (Direction)d;
+            }
+        }
+        return best;
+    }
+};
+
+class ExpectimaxPolicy : public Policy {
+public:
+    ExpectimaxPolicy(int depth, const BoardEvaluator *evaluator) : ai(depth, 1) {
+        ai.evaluator = evaluator;
+    }
+
+    Direction choose(WideBoard b, GameRandom &) override {
+        return ai.search(b).move;
+    }
+
+private:
+    GameAI ai;
+};
+
+// Takes the move with the best reward plus afterstate value.
+class NTuplePolicy : public Policy {
+public:
+    explicit NTuplePolicy(const NTupleNetwork *n) : network(n) {}
+
+    Direction choose(WideBoard b, GameRandom &) override {
+        Direction best = Direction::Up;
+        double bestValue = 0;
+        bool found = false;
+        for (int d = 0; d < 4; ++d) {
+            int64_t reward = 0;
+            WideBoard next = wide_move(b, (Direction)d, &reward);
+            if (next == b) continue;
+            double value = (double)reward + (next.high == 0 ? network->evaluate(next.low) : network->evaluate_wide(next));
+            if (!found || value > bestValue) {
+                found = true;
+                bestValue = value;
+                best = (Direction)d;
+            }
+        }
+        return best;
+    }
+
+private:
+    const NTupleNetwork *network;
+};
+
+static Policy *make_policy(const SimOptions &options) {
+    if (options.policy == "greedy") return new GreedyPolicy;
+    if (options.policy == "expectimax") return new ExpectimaxPolicy(options.depth, options.network);
+    if (options.policy == "ntuple") return new NTuplePolicy(options.network);
+    return new RandomPolicy;
+}
+
+// Scores go into log-spaced buckets, 8 per power of two, so the memory
+// used does not depend on the number of games.
+struct SimStats {
+    static const int SCORE_BUCKETS = 8 * 40;
+
+    uint64_t games = 0;
+    uint64_t moves = 0;
+    uint64_t minMoves = UINT64_MAX, maxMoves = 0;
+    double scoreSum = 0;
+    int64_t minScore = INT64_MAX, maxScore = 0;
+    uint64_t scoreBuckets[SCORE_BUCKETS] = {};
+    uint64_t maxTiles[MAX_WIDE_TILE_EXPONENT + 1] = {};
+
+    static int score_bucket(int64_t score) {
+        if (score <= 0) return 0;
+        int bucket = (int)(std::log2((double)score) * 8);
+        return std::min(bucket, SCORE_BUCKETS - 1);
+    }
+
+    void add_game(int64_t score, uint64_t gameMoves, int maxTile) {
+        games++;
+        moves += gameMoves;
+        minMoves = std::min(minMoves, gameMoves);
+        maxMoves = std::max(maxMoves, gameMoves);
+        scoreSum += (double)score;
+        minScore = std::min(minScore, score);
+        maxScore = std::max(maxScore, score);
+        scoreBuckets[score_bucket(score)]++;
+        maxTiles[maxTile]++;
+    }
+
+    void merge(const SimStats &other) {
+        games += other.games;
+        moves += other.moves;
+        minMoves = std::min(minMoves, other.minMoves);
+        maxMoves = std::max(maxMoves, other.maxMoves);
+        scoreSum += other.scoreSum;
+        minScore = std::min(minScore, other.minScore);
+        maxScore = std::max(maxScore, other.maxScore);
+        for (int i = 0; i < SCORE_BUCKETS; ++i) scoreBuckets[i] += other.scoreBuckets[i];
+        for (int i = 0; i <= MAX_WIDE_TILE_EXPONENT; ++i) maxTiles[i] += other.maxTiles[i];
+    }
+
+    // Lower edge of the bucket holding the given fraction of games.
+    int64_t score_percentile(double fraction) const {
+        auto target = (uint64_t)std::ceil(fraction * (double)games);
+        uint64_t seen = 0;
+        for (int i = 0; i < SCORE_BUCKETS; ++i) {
+            seen += scoreBuckets[i];
+            if (seen >= target && seen > 0) return i == 0 ? 0 : (int64_t)std::exp2(i / 8.0);
+        }
+        return maxScore;
+    }
+};
+
+// The random and greedy policies for GridGame boards.
+static Direction choose_grid_move(const SimOptions &options, const GridGame &game, GameRandom &random) {
+    Direction legal[4];
+    int count = 0;
+    Direction best = Direction::Up;
+    int64_t bestKey = -1;
+    for (int d = 0; d < 4; ++d) {
+        int64_t gained = 0;
+        GridBoard next = game.moved((Direction)d, &gained);
+        if (next == game.board) continue;
+        legal[count++] = (Direction)d;
+        int64_t key = gained * 256 + game.empty_count(next) * 2 + (random.next() & 1);
+        if (key > bestKey) {
+            bestKey = key;
+            best = (Direction)d;
+        }
+    }
+    return options.policy == "greedy" ? best : legal[random.bounded(count)];
+}
+
+static void play_grid_games(const SimOptions &options, uint64_t first, uint64_t count, SimStats &stats) {
+    for (uint64_t i = first; i < first + count; ++i) {
+        GridGame game(options.size, options.seed * 0x9E3779B97F4A7C15ULL + i);
+        GameRandom policyRandom(~i);
+        game.new_game();
+        uint64_t moves = 0;
+        while (game.can_move()) {
+            game.move(choose_grid_move(options, game, policyRandom));
+            moves++;
+        }
+        stats.add_game(game.score, moves, game.max_tile());
+    }
+}
+
+static void play_games(const SimOptions &options, uint64_t first, uint64_t count, SimStats &stats) {
+    if (options.size != BOARD_SIZE) {
+        play_grid_games(options, first, count, stats);
+        return;
+    }
+    thread_local std::unique_ptr<Policy> policy;
+    if (!policy) policy.reset(make_policy(options));
+
+    for (uint64_t i = first; i < first + count; ++i) {
+        // Each game gets its own seed, so results do not depend on the
+        // number of threads or on which thread played the game.
+        uint64_t seed = options.seed * 0x9E3779B97F4A7C15ULL + i;
+        GameEngine game(seed);
+        GameRandom policyRandom(~i);
+        ReplayWriter journal;
+        if (!options.journalDir.empty()) {
+            journal.open(options.journalDir + "/game" + std::to_string(i) + ".2048replay", seed);
+        }
+        game.new_game();
+        uint64_t moves = 0;
+        while (game.can_move()) {
+            Direction d = policy->choose(game.wide_board(), policyRandom);
+            game.move(d);
+            journal.record_move(d, game);
+            moves++;
+        }
+        stats.add_game(game.score, moves, game.max_tile());
+    }
+}
+
+static void print_report(const SimStats &stats, double seconds, int threads) {
+    printf("games        %llu in %.2f s on %d threads, %.1f games/s, %.0f moves/s\n",
+           (unsigned long long)stats.games, seconds, threads, stats.games / seconds, stats.moves / seconds);
+    printf("moves/game   mean %.1f  min %llu  max %llu\n", (double)stats.moves / stats.games,
+           (unsigned long long)stats.minMoves, (unsigned long long)stats.maxMoves);
+    printf("score        mean %.1f  min %lld  max %lld\n", stats.scoreSum / stats.games,
+           (long long)stats.minScore, (long long)stats.maxScore);
+    printf("score pct    p10 >= %lld  p50 >= %lld  p90 >= %lld  p99 >= %lld\n",
+           (long long)stats.score_percentile(0.10), (long long)stats.score_percentile(0.50),
+           (long long)stats.score_percentile(0.90), (long long)stats.score_percentile(0.99));
+
+    printf("\nscore distribution\n");
+    for (int octave = 0; octave < SimStats::SCORE_BUCKETS / 8; ++octave) {
+        uint64_t count = 0;
+        for (int i = 0; i < 8; ++i) count += stats.scoreBuckets[octave * 8 + i];
+        if (count == 0) continue;
+        printf("  [%9lld, %9lld)  %10llu  %6.2f%%\n", octave == 0 ? 0LL : 1LL << octave, 1LL << (octave + 1),
+               (unsigned long long)count, 100.0 * count / stats.games);
+    }
+
+    printf("\nmax tile\n");
+    uint64_t reached = stats.games;
+    for (int tile = 1; tile <= MAX_WIDE_TILE_EXPONENT; ++tile) {
+        if (stats.maxTiles[tile] != 0) {
+            printf("  %6lld  %10llu  %6.2f%%  (reached by %.2f%%)\n", 1LL << tile, (unsigned long long)stats.maxTiles[tile],
+                   100.0 * stats.maxTiles[tile] / stats.games, 100.0 * reached / stats.games);
+        }
+        reached -= stats.maxTiles[tile];
+    }
+}
+
+static bool parse_options(int argc, char *argv[], SimOptions &options) {
+    for (int i = 1; i < argc; ++i) {
+        if (i + 1 >= argc) return false;
+        const char *value = argv[++i];
+        if (strcmp(argv[i - 1], "-n") == 0) options.games = strtoull(value, nullptr, 10);
+        else if (strcmp(argv[i - 1], "-p") == 0) options.policy = value;
+        else if (strcmp(argv[i - 1], "-d") == 0) options.depth = atoi(value);
+        else if (strcmp(argv[i - 1], "-t") == 0) options.threads = atoi(value);
+        else if (strcmp(argv[i - 1], "-s") == 0) options.seed = strtoull(value, nullptr, 10);
+        else if (strcmp(argv[i - 1], "-w") == 0) options.weights = value;
+        else if (strcmp(argv[i - 1], "-R") == 0) options.rowTables = value;
+        else if (strcmp(argv[i - 1], "-j") == 0) options.journalDir = value;
+        else if (strcmp(argv[i - 1], "-b") == 0) options.size = atoi(value);
+        else return false;
+    }
+    if (options.size < MIN_BOARD_SIZE || options.size > MAX_BOARD_SIZE) return false;
+    if (options.size != BOARD_SIZE) {
+        return options.journalDir.empty() && (options.policy == "random" || options.policy == "greedy");
+    }
+    if (options.policy == "ntuple") return !options.weights.empty();
+    return options.policy == "random" || options.policy == "greedy" || options.policy == "expectimax";
+}
+
+int main(int argc, char *argv[]) {
+    SimOptions options;
+    if (!parse_options(argc, argv, options)) {
+        fprintf(stderr, "usage: %s [-n games] [-p random|greedy|expectimax|ntuple] [-d depth] [-t threads] "
+                        "[-s seed] [-w weights] [-R rowtables] [-j dir] [-b size]\n", argv[0]);
+        return 1;
+    }
+
+    if (!options.rowTables.empty() && !load_row_tables(options.rowTables) && !save_row_tables(options.rowTables)) {
+        fprintf(stderr, "cannot save %s\n", options.rowTables.c_str());
+        return 1;
+    }
+
+    std::unique_ptr<NTupleNetwork> network;
+    if (!options.weights.empty()) {
+        network.reset(new NTupleNetwork(NTupleNetwork::patterns("4tuple")));
+        if (!network->load(options.weights)) {
+            fprintf(stderr, "cannot load %s\n", options.weights.c_str());
+            return 1;
+        }
+        options.network = network.get();
+    }
+
+    ThreadPool pool(options.threads);
+    SimStats total;
+    std::mutex totalMutex;
+
+    // Cheap policies play many games per task to keep scheduling overhead
+    // out of the numbers; expectimax games are long enough on their own.
+    uint64_t chunk = options.policy == "expectimax" ? 1 : 256;
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t first = 0; first < options.games; first += chunk) {
+        uint64_t count = std::min(chunk, options.games - first);
+        pool.submit([&options, &total, &totalMutex, first, count] {
+            SimStats stats;
+            play_games(options, first, count, stats);
+            std::lock_guard<std::mutex> lock(totalMutex);
+            total.merge(stats);
+        });
+    }
+    pool.wait();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    print_report(total, seconds, pool.size());
+    return 0;
+}
@@ -0,0 +1,205 @@
+//
+// Created by Rache on 2026/10/17.
+//
+
+#include "TableFile.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const char TABLE_MAGIC[8] = {'2', '0', '4', '8', 'T', 'B', 'L', 0};
+static const uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+static uint64_t header_check(const TableFileHeader &header) {
+    return TableFile::hash(&header, offsetof(TableFileHeader, headerCheck));
+}
+
+uint64_t TableFile::hash(const void *data, size_t size, uint64_t h) {
+    const auto *bytes = (const uint8_t *)data;
+    for (size_t i = 0; i < size; ++i) {
+        h ^= bytes[i];
+        h *= 0x100000001B3ULL;
+    }
+    return h;
+}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::open(const std::string &path) {
+    close();
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart <= 0) {
+        CloseHandle(file);
+        return false;
+    }
+    // The mapping keeps the file open.
+    mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (!mapping) return false;
+    base = (const uint8_t *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!base) {
+        CloseHandle(mapping);
+        mapping = nullptr;
+        return false;
+    }
+    length = (size_t)fileSize.QuadPart;
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        ::close(fd);
+        return false;
+    }
+    void *address = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (address == MAP_FAILED) return false;
+    base = (const uint8_t *)address;
+    length = (size_t)st.st_size;
+#endif
+    return true;
+}
+
+void MappedFile::close() {
+    if (!base) return;
+#ifdef _WIN32
+    UnmapViewOfFile(base);
+    CloseHandle(mapping);
+    mapping = nullptr;
+#else
+    munmap((void *)base, length);
+#endif
+    base = nullptr;
+    length = 0;
+}
+
+// Makes the rename itself durable by syncing the directory holding `path`.
+static void sync_directory(const std::string &path) {
+#ifndef _WIN32
+    size_t slash = path.find_last_of('/');
+    std::string directory = slash == std::string::npos ? "." : slash == 0 ? "/" : path.substr(0, slash);
+    int fd = ::open(directory.c_str(), O_RDONLY);
+    if (fd < 0) return;
+    fsync(fd);
+    ::close(fd);
+#else
+    (void)path;
+#endif
+}
+
+// Creates a temporary file next to `path` that no other writer has, so
+// processes replacing the same file at once never write into each other's.
+static FILE *create_temporary(const std::string &path, std::string &temporary) {
+    static std::atomic<uint32_t> counter{0};
+#ifdef _WIN32
+    unsigned long process = GetCurrentProcessId();
+#else
+    unsigned long process = (unsigned long)getpid();
+#endif
+    for (int attempt = 0; attempt < 100; ++attempt) {
+        temporary = path + "." + std::to_string(process) + "." + std::to_string(counter++) + ".tmp";
+#ifdef _WIN32
+        int fd = _open(temporary.c_str(), _O_WRONLY | _O_CREAT | _O_EXCL | _O_BINARY, _S_IREAD | _S_IWRITE);
+        if (fd >= 0) return _fdopen(fd, "wb");
+#else
+        int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0666);
+        if (fd >= 0) return fdopen(fd, "wb");
+#endif
+        if (errno != EEXIST) return nullptr;
+    }
+    return nullptr;
+}
+
+bool replace_file(const std::string &path, std::initializer_list<FilePart> parts, bool sync) {
+    std::string temporary;
+    FILE *f = create_temporary(path, temporary);
+    if (!f) return false;
+    bool ok = true;
+    for (const FilePart &part : parts) ok = ok && (part.size == 0 || fwrite(part.data, part.size, 1, f) == 1);
+    if (sync) {
+        ok = ok && fflush(f) == 0;
+#ifdef _WIN32
+        ok = ok && FlushFileBuffers((HANDLE)_get_osfhandle(_fileno(f)));
+#else
+        ok = ok && fsync(fileno(f)) == 0;
+#endif
+    }
+    ok = fclose(f) == 0 && ok;
+#ifdef _WIN32
+    ok = ok && MoveFileExA(temporary.c_str(), path.c_str(),
+                           MOVEFILE_REPLACE_EXISTING | (sync ? MOVEFILE_WRITE_THROUGH : 0));
+#else
+    ok = ok && rename(temporary.c_str(), path.c_str()) == 0;
+    if (ok && sync) sync_directory(path);
+#endif
+    if (!ok) remove(temporary.c_str());
+    return ok;
+}
+
+bool TableFile::open(const std::string &path, TableKind kind, uint64_t layout) {
+    close();
+    if (!file.open(path)) return false;
+    size_t size = file.size();
+    if (size < sizeof(TableFileHeader)) {
+        close();
+        return false;
+    }
+
+    const TableFileHeader &h = *header();
+    bool ok = memcmp(h.magic, TABLE_MAGIC, sizeof(TABLE_MAGIC)) == 0 &&
+              h.headerCheck == header_check(h) &&
+              h.version == TABLE_FILE_VERSION &&
+              h.byteOrder == BYTE_ORDER_MARK &&
+              h.kind == (uint32_t)kind &&
+              h.layout == layout &&
+              sizeof(TableFileHeader) + h.metaSize <= h.payloadOffset &&
+              h.payloadOffset % TABLE_FILE_ALIGNMENT == 0 &&
+              h.payloadOffset <= size && h.payloadSize <= size - h.payloadOffset;
+    if (!ok) close();
+    return ok;
+}
+
+void TableFile::close() {
+    file.close();
+}
+
+bool TableFile::write(const std::string &path, TableKind kind, uint64_t layout,
+                      const void *meta, size_t metaSize, const void *payload, size_t payloadSize) {
+    TableFileHeader header{};
+    memcpy(header.magic, TABLE_MAGIC, sizeof(TABLE_MAGIC));
+    header.version = TABLE_FILE_VERSION;
+    header.kind = (uint32_t)kind;
+    header.byteOrder = BYTE_ORDER_MARK;
+    header.metaSize = (uint32_t)metaSize;
+    header.layout = layout;
+    header.payloadOffset = (sizeof(header) + metaSize + TABLE_FILE_ALIGNMENT - 1) / TABLE_FILE_ALIGNMENT
+                         * TABLE_FILE_ALIGNMENT;
+    header.payloadSize = payloadSize;
+    header.headerCheck = header_check(header);
+
+    std::vector<char> padding(header.payloadOffset - sizeof(header) - metaSize, 0);
+    return replace_file(path, {{&header, sizeof(header)}, {meta, metaSize}, {padding.data(), padding.size()},
+                               {payload, payloadSize}});
+}
@@ -0,0 +1,111 @@
+//
+// Created by Rache on 2026/10/17.
+//
+
+#ifndef INC_2048GAME_TABLEFILE_H
+#define INC_2048GAME_TABLEFILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+
+// A whole file mapped read-only and shared.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    // Fails when the file is missing or empty.
+    bool open(const std::string &path);
+    void close();
+    bool is_open() const { return base != nullptr; }
+    const uint8_t *data() const { return base; }
+    size_t size() const { return length; }
+
+private:
+    const uint8_t *base = nullptr;
+    size_t length = 0;
+#ifdef _WIN32
+    void *mapping = nullptr;
+#endif
+};
+
+struct FilePart {
+    const void *data;
+    size_t size;
+};
+
+// Writes the parts to a sibling temporary file, unique to this write, and
+// renames it over `path`, so readers, mappings of the old file and other
+// writers never see a half-written one.
+// With `sync` the data and the rename reach the disk before it returns, so
+// a crash leaves either the old file or the new one.
+bool replace_file(const std::string &path, std::initializer_list<FilePart> parts, bool sync = false);
+
+// Precomputed tables (row transitions, n-tuple weights) stored so they can
+// be memory-mapped and used in place:
+//
+//   header    64 bytes, see TableFileHeader
+//   meta      what the payload means, e.g. the n-tuple layout
+//   payload   the table itself, starting on a 4096-byte boundary
+//
+// The mapping is read-only and shared, so opening a table costs no parsing
+// and every process that maps the same file shares its physical pages.
+static const uint32_t TABLE_FILE_VERSION = 1;
+static const size_t TABLE_FILE_ALIGNMENT = 4096;
+
+enum class TableKind : uint32_t {
+    RowTables = 1,
+    NTupleWeights = 2
+};
+
+struct TableFileHeader {
+    char magic[8];              // "2048TBL" and a NUL
+    uint32_t version;           // TABLE_FILE_VERSION
+    uint32_t kind;              // TableKind
+    uint32_t byteOrder;         // 0x01020304 as written by the producing machine
+    uint32_t metaSize;
+    uint64_t layout;            // fingerprint of the producer's table layout
+    uint64_t payloadOffset;
+    uint64_t payloadSize;
+    uint64_t headerCheck;       // FNV-1a of the fields above
+    uint64_t reserved;
+};
+
+class TableFile {
+public:
+    TableFile() = default;
+    TableFile(const TableFile &) = delete;
+    TableFile &operator=(const TableFile &) = delete;
+
+    // Maps the file and checks its header. Fails when the file is missing
+    // or truncated, or was written by another format version, for another
+    // kind of table, on a machine of the other byte order or with another
+    // layout than `layout`.
+    bool open(const std::string &path, TableKind kind, uint64_t layout);
+    void close();
+    bool is_open() const { return file.is_open(); }
+
+    const void *meta() const { return file.data() + sizeof(TableFileHeader); }
+    size_t meta_size() const { return header()->metaSize; }
+    const void *payload() const { return file.data() + header()->payloadOffset; }
+    size_t payload_size() const { return (size_t)header()->payloadSize; }
+
+    // Goes through replace_file.
+    static bool write(const std::string &path, TableKind kind, uint64_t layout,
+                      const void *meta, size_t metaSize, const void *payload, size_t payloadSize);
+
+    // FNV-1a, for layout fingerprints.
+    static uint64_t hash(const void *data, size_t size, uint64_t h = 0xCBF29CE484222325ULL);
+
+private:
+    const TableFileHeader *header() const { return (const TableFileHeader *)file.data(); }
+
+    MappedFile file;
+};
+
+
+#endif //INC_2048GAME_TABLEFILE_H
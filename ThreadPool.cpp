@@ -0,0 +1,98 @@
+//
+// Created by Rache on 2026/10/17.
+//
+
+#include "ThreadPool.h"
+
+// Index of the pool worker running on this thread, -1 elsewhere.
+static thread_local const ThreadPool *currentPool = nullptr;
+static thread_local int currentWorker = -1;
+
+ThreadPool::ThreadPool(int threads) {
+    if (threads <= 0) threads = hardware_threads();
+    for (int i = 0; i < threads; ++i) {
+        queues.emplace_back(new WorkQueue);
+    }
+    for (int i = 0; i < threads; ++i) {
+        workers.emplace_back(&ThreadPool::worker_loop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    taskAvailable.notify_all();
+    for (auto &worker : workers) worker.join();
+}
+
+int ThreadPool::hardware_threads() {
+    unsigned n = std::thread::hardware_concurrency();
+    return n == 0 ? 1 : (int)n;
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    int index = currentPool == this ? currentWorker : (int)(nextQueue++ % queues.size());
+    {
+        std::lock_guard<std::mutex> lock(queues[index]->mutex);
+        queues[index]->tasks.push_back(std::move(task));
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queued++;
+        pending++;
+    }
+    taskAvailable.notify_one();
+}
+
+void ThreadPool::wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    allDone.wait(lock, [this] { return pending == 0; });
+}
+
+bool ThreadPool::pop_task(int index, std::function<void()> &task) {
+    WorkQueue &queue = *queues[index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty()) return false;
+    task = std::move(queue.tasks.back());
+    queue.tasks.pop_back();
+    return true;
+}
+
+bool ThreadPool::steal_task(int index, std::function<void()> &task) {
+    int n = (int)queues.size();
+    for (int i = 1; i < n; ++i) {
+        WorkQueue &queue = *queues[(index + i) % n];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty()) continue;
+        task = std::move(queue.tasks.front());
+        queue.tasks.pop_front();
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::worker_loop(int index) {
+    currentPool = this;
+    currentWorker = index;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            taskAvailable.wait(lock, [this] { return stopping || queued > 0; });
+            if (queued == 0) return;
+            // Claim one task; it is in some deque and nobody else can take
+            // it once the count is down.
+            queued--;
+        }
+
+        std::function<void()> task;
+        while (!pop_task(index, task) && !steal_task(index, task)) {
+            std::this_thread::yield();
+        }
+        task();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--pending == 0) allDone.notify_all();
+    }
+}
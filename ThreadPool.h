@@ -0,0 +1,57 @@
+//
+// Created by Rache on 2026/10/17.
+//
+
+#ifndef INC_2048GAME_THREADPOOL_H
+#define INC_2048GAME_THREADPOOL_H
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <condition_variable>
+#include <functional>
+
+// Work-stealing pool. Every worker owns a task deque: tasks submitted from
+// a worker go to the back of its own deque and it pops from the back, so
+// related work stays on one core; tasks submitted from outside are dealt
+// round-robin. A worker whose deque is empty steals from the front of the
+// others. wait() must not be called from a task, or the worker running it
+// would wait for itself.
+class ThreadPool {
+public:
+    explicit ThreadPool(int threads = 0);   // 0: one per hardware thread
+    ~ThreadPool();
+
+    void submit(std::function<void()> task);
+    void wait();
+    int size() const { return (int)workers.size(); }
+
+    static int hardware_threads();
+
+private:
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    void worker_loop(int index);
+    bool pop_task(int index, std::function<void()> &task);
+    bool steal_task(int index, std::function<void()> &task);
+
+    std::vector<std::thread> workers;
+    std::vector<std::unique_ptr<WorkQueue>> queues;
+    std::atomic<unsigned> nextQueue{0};
+
+    std::mutex mutex;
+    std::condition_variable taskAvailable;
+    std::condition_variable allDone;
+    int queued = 0;         // submitted but not yet taken, guarded by mutex
+    int pending = 0;        // submitted but not yet finished, guarded by mutex
+    bool stopping = false;
+};
+
+
+#endif //INC_2048GAME_THREADPOOL_H
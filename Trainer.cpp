@@ -0,0 +1,219 @@
+//
+// Created by Rache on 2026/10/17.
+//
+// Trains an n-tuple network by self-play with afterstate TD(0), optionally
+// with TC (temporal coherence) learning rates, on every core.
+//
+// usage: 2048Train [-p 6tuple|4tuple] [-e episodes] [-t threads] [-a alpha]
+//                  [-tc] [-i weights] [-o weights] [-r report] [-s seed]
+//
+// Episodes play on a WideBoard, so tiles merge past 32768. The tuples'
+// weight indexes are 4-bit, so they see those tiles as 32768.
+//
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "NTupleNetwork.h"
+
+struct TrainOptions {
+    std::string pattern = "6tuple";
+    uint64_t episodes = 100000;
+    int threads = 0;
+    float alpha = 0.1f;
+    bool tc = false;
+    std::string input;
+    std::string output = "ntuple.weights";
+    uint64_t report = 1000;
+    uint64_t seed = 1;
+};
+
+struct TrainStats {
+    uint64_t episodes = 0;
+    double scoreSum = 0;
+    int64_t maxScore = 0;
+    uint64_t reached[MAX_WIDE_TILE_EXPONENT + 1] = {};
+};
+
+// Threads update the shared weights without locks (Hogwild style): two
+// threads rarely touch the same weight at once, and a lost update only
+// costs one step of learning.
+class Trainer {
+public:
+    Trainer(NTupleNetwork &n, const TrainOptions &o) : network(n), options(o) {
+        if (options.tc) {
+            errors.assign(network.weight_count(), 0.0f);
+            absErrors.assign(network.weight_count(), 0.0f);
+        }
+    }
+
+    void run();
+
+private:
+    void play_episodes(int thread);
+    void learn(Board afterstate, float target);
+    void episode_finished(int64_t score, int maxTile);
+
+    NTupleNetwork &network;
+    const TrainOptions &options;
+    std::vector<float> errors;      // TC: sum of errors per weight
+    std::vector<float> absErrors;   // TC: sum of absolute errors per weight
+
+    std::atomic<uint64_t> nextEpisode{0};
+    std::mutex statsMutex;
+    TrainStats block;
+    std::chrono::steady_clock::time_point blockStart;
+};
+
+void Trainer::run() {
+    int threads = options.threads > 0 ? options.threads : ThreadPool::hardware_threads();
+    // A loaded network copies its mapped weights on the first writable
+    // access and unmaps the file, which must not happen under a worker
+    // still reading the mapping.
+    network.weights();
+    blockStart = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (int i = 0; i < threads; ++i) workers.emplace_back(&Trainer::play_episodes, this, i);
+    for (auto &worker : workers) worker.join();
+}
+
+void Trainer::play_episodes(int thread) {
+    GameRandom random(options.seed * 0x9E3779B97F4A7C15ULL + thread);
+    while (nextEpisode++ < options.episodes) {
+        WideBoard b = wide_spawn(wide_spawn(WideBoard(), random), random);
+        int64_t score = 0;
+        Board previous = 0;
+        bool hasPrevious = false;
+
+        while (true) {
+            // Greedy on reward + value of the afterstate.
+            WideBoard bestAfterstate;
+            int64_t bestReward = 0;
+            double bestValue = 0;
+            bool found = false;
+            for (int d = 0; d < 4; ++d) {
+                int64_t reward = 0;
+                WideBoard afterstate = wide_move(b, (Direction)d, &reward);
+                if (afterstate == b) continue;
+                double value = (double)reward + network.evaluate(wide_capped(afterstate));
+                if (!found || value > bestValue) {
+                    found = true;
+                    bestValue = value;
+                    bestReward = reward;
+                    bestAfterstate = afterstate;
+                }
+            }
+            if (!found) break;
+
+            if (hasPrevious) learn(previous, (float)bestValue);
+            previous = wide_capped(bestAfterstate);
+            hasPrevious = true;
+            score += bestReward;
+            b = wide_spawn(bestAfterstate, random);
+        }
+        if (hasPrevious) learn(previous, 0);
+
+        episode_finished(score, wide_max_tile(b));
+    }
+}
+
+void Trainer::learn(Board afterstate, float target) {
+    uint32_t indexes[NTupleNetwork::MAX_FEATURES];
+    int count = network.features(afterstate, indexes);
+    float *w = network.weights();
+
+    float value = 0;
+    for (int i = 0; i < count; ++i) value += w[indexes[i]];
+    float error = target - value;
+    float step = options.alpha / (float)count * error;
+
+    if (!options.tc) {
+        for (int i = 0; i < count; ++i) w[indexes[i]] += step;
+        return;
+    }
+    for (int i = 0; i < count; ++i) {
+        uint32_t k = indexes[i];
+        float rate = absErrors[k] == 0 ? 1.0f : std::fabs(errors[k]) / absErrors[k];
+        w[k] += step * rate;
+        errors[k] += error;
+        absErrors[k] += std::fabs(error);
+    }
+}
+
+void Trainer::episode_finished(int64_t score, int maxTile) {
+    std::lock_guard<std::mutex> lock(statsMutex);
+    block.episodes++;
+    block.scoreSum += (double)score;
+    if (score > block.maxScore) block.maxScore = score;
+    for (int tile = 1; tile <= maxTile; ++tile) block.reached[tile]++;
+
+    if (block.episodes < options.report) return;
+    auto now = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(now - blockStart).count();
+    printf("%10llu  mean %9.1f  max %8lld  2048 %5.1f%%  4096 %5.1f%%  8192 %5.1f%%  16384 %5.1f%%  32768 %5.1f%%  "
+           "%7.1f episodes/s\n",
+           (unsigned long long)std::min<uint64_t>(nextEpisode, options.episodes),
+           block.scoreSum / block.episodes, (long long)block.maxScore,
+           100.0 * block.reached[11] / block.episodes, 100.0 * block.reached[12] / block.episodes,
+           100.0 * block.reached[13] / block.episodes, 100.0 * block.reached[14] / block.episodes,
+           100.0 * block.reached[15] / block.episodes, block.episodes / seconds);
+    fflush(stdout);
+    block = TrainStats();
+    blockStart = now;
+}
+
+static bool parse_options(int argc, char *argv[], TrainOptions &options) {
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-tc") == 0) {
+            options.tc = true;
+            continue;
+        }
+        if (i + 1 >= argc) return false;
+        const char *value = argv[++i];
+        if (strcmp(argv[i - 1], "-p") == 0) options.pattern = value;
+        else if (strcmp(argv[i - 1], "-e") == 0) options.episodes = strtoull(value, nullptr, 10);
+        else if (strcmp(argv[i - 1], "-t") == 0) options.threads = atoi(value);
+        else if (strcmp(argv[i - 1], "-a") == 0) options.alpha = (float)atof(value);
+        else if (strcmp(argv[i - 1], "-i") == 0) options.input = value;
+        else if (strcmp(argv[i - 1], "-o") == 0) options.output = value;
+        else if (strcmp(argv[i - 1], "-r") == 0) options.report = strtoull(value, nullptr, 10);
+        else if (strcmp(argv[i - 1], "-s") == 0) options.seed = strtoull(value, nullptr, 10);
+        else return false;
+    }
+    return (options.pattern == "6tuple" || options.pattern == "4tuple") && options.report > 0;
+}
+
+int main(int argc, char *argv[]) {
+    TrainOptions options;
+    if (!parse_options(argc, argv, options)) {
+        fprintf(stderr, "usage: %s [-p 6tuple|4tuple] [-e episodes] [-t threads] [-a alpha] [-tc] "
+                        "[-i weights] [-o weights] [-r report] [-s seed]\n", argv[0]);
+        return 1;
+    }
+
+    NTupleNetwork network(NTupleNetwork::patterns(options.pattern));
+    if (!options.input.empty() && !network.load(options.input)) {
+        fprintf(stderr, "cannot load %s\n", options.input.c_str());
+        return 1;
+    }
+    printf("%d tuples, %zu weights, %s, alpha %g\n", network.tuple_count(), network.weight_count(),
+           options.tc ? "TC learning" : "TD(0)", options.alpha);
+
+    Trainer trainer(network, options);
+    trainer.run();
+
+    if (!network.save(options.output)) {
+        fprintf(stderr, "cannot save %s\n", options.output.c_str());
+        return 1;
+    }
+    printf("saved %s\n", options.output.c_str());
+    return 0;
+}
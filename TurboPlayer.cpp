@@ -0,0 +1,59 @@
+//
+// Created by Rache on 2026/10/17.
+//
+
+#include "TurboPlayer.h"
+
+TurboPlayer::~TurboPlayer() {
+    stop();
+}
+
+void TurboPlayer::start(const GameEngine &game, int depth, const BoardEvaluator *evaluator) {
+    stop();
+    pending.clear();
+    finished = false;
+    stopping = false;
+    played = 0;
+    worker = std::thread(&TurboPlayer::worker_loop, this, game, depth, evaluator);
+}
+
+void TurboPlayer::stop() {
+    if (!worker.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    drained.notify_one();
+    worker.join();
+}
+
+bool TurboPlayer::take_moves(std::vector<Direction> &moves) {
+    bool more;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        moves.insert(moves.end(), pending.begin(), pending.end());
+        pending.clear();
+        more = !finished;
+    }
+    drained.notify_one();
+    return more;
+}
+
+void TurboPlayer::worker_loop(GameEngine game, int depth, const BoardEvaluator *evaluator) {
+    GameAI ai(depth, 1);
+    ai.evaluator = evaluator;
+    for (;;) {
+        SearchResult result = ai.search(game.wide_board());
+        if (result.found) game.move(result.move);
+
+        std::unique_lock<std::mutex> lock(mutex);
+        if (!result.found) {
+            finished = true;
+            return;
+        }
+        drained.wait(lock, [this] { return pending.size() < MAX_PENDING_MOVES || stopping; });
+        if (stopping) return;
+        pending.push_back(result.move);
+        played++;
+    }
+}
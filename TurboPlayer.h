@@ -0,0 +1,60 @@
+//
+// Created by Rache on 2026/10/17.
+//
+
+#ifndef INC_2048GAME_TURBOPLAYER_H
+#define INC_2048GAME_TURBOPLAYER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "GameEngine.h"
+#include "GameAI.h"
+
+// Plays a game on a background thread as fast as a shallow single-threaded
+// search allows, independent of how often the caller looks at it. The
+// worker plays its own copy of the game and queues the moves it makes; the
+// caller replays them with take_moves() on its copy, which ends up in the
+// same state because the spawns come from the same random state.
+//
+// The queue holds at most MAX_PENDING_MOVES; a worker that gets that far
+// ahead waits for the caller to catch up.
+class TurboPlayer {
+public:
+    static const size_t MAX_PENDING_MOVES = 1 << 16;
+
+    TurboPlayer() = default;
+    ~TurboPlayer();
+    TurboPlayer(const TurboPlayer &) = delete;
+    TurboPlayer &operator=(const TurboPlayer &) = delete;
+
+    // Stops any game in progress and starts playing from `game`. The
+    // evaluator is not owned and must stay valid until stop().
+    void start(const GameEngine &game, int depth, const BoardEvaluator *evaluator);
+    // Stops the worker and drops the moves not taken yet.
+    void stop();
+    bool running() const { return worker.joinable(); }
+
+    // Appends the moves played since the last call. Returns false once the
+    // game is over and every move has been taken.
+    bool take_moves(std::vector<Direction> &moves);
+    // Moves played by the worker since start(), taken or not.
+    uint64_t move_count() const { return played; }
+
+private:
+    void worker_loop(GameEngine game, int depth, const BoardEvaluator *evaluator);
+
+    std::mutex mutex;
+    std::condition_variable drained;
+    std::vector<Direction> pending;     // guarded by mutex
+    bool finished = false;              // guarded by mutex
+    bool stopping = false;              // guarded by mutex
+    std::atomic<uint64_t> played{0};
+    std::thread worker;
+};
+
+
+#endif //INC_2048GAME_TURBOPLAYER_H
@@ -0,0 +1,317 @@
+//
+// Created by Rache on 2026/10/17.
+//
+
+#include "UndoHistory.h"
+
+#include <algorithm>
+#include <cstring>
+
+// Code byte: bits 0-1 direction, bits 2-5 spawn cell, bit 6 set for a 4.
+bool encode_step(const GameState &from, const GameState &to, uint8_t *code) {
+    for (int d = 0; d < 4; ++d) {
+        int64_t gained = 0;
+        WideBoard moved = wide_move(from.wide_board(), (Direction)d, &gained);
+        if (moved == from.wide_board() || from.score + gained != to.score || moved.high != to.high) continue;
+        // Exactly one cell differs, it was empty, and it now holds a 2 or a 4.
+        Board diff = to.board ^ moved.low;
+        if (diff == 0) continue;
+        int cell = __builtin_ctzll(diff) / 4;
+        if ((diff >> (4 * cell)) > 0xf) continue;
+        int number = (int)((to.board >> (4 * cell)) & 0xf);
+        if ((((moved.low | moved.high) >> (4 * cell)) & 0xf) != 0 || (number != 1 && number != 2)) continue;
+        *code = (uint8_t)(d | cell << 2 | (number - 1) << 6);
+        return true;
+    }
+    return false;
+}
+
+GameState decode_step(const GameState &from, uint8_t code) {
+    GameState state = from;
+    WideBoard moved = wide_move(from.wide_board(), (Direction)(code & 3), &state.score);
+    state.board = moved.low | (Board)(((code >> 6) & 1) + 1) << (4 * ((code >> 2) & 0xf));
+    state.high = moved.high;
+    return state;
+}
+
+void UndoHistory::reset(GameState root) {
+    branches.clear();
+    redoChoices.clear();
+    branches.push_back({NONE, 0, {KEYFRAME}, {{0, root}}, {}});
+    stateCount = 1;
+    currentNode = make_node(0, 0);
+    currentState = root;
+}
+
+size_t UndoHistory::memory_usage() const {
+    size_t bytes = branches.capacity() * sizeof(Branch) +
+                   redoChoices.size() * (2 * sizeof(NodeId) + sizeof(void *)) +
+                   redoChoices.bucket_count() * sizeof(void *);
+    for (const Branch &branch : branches) {
+        bytes += branch.codes.capacity() + branch.keyframes.capacity() * sizeof(branch.keyframes[0]) +
+                 branch.forks.capacity() * sizeof(uint32_t);
+    }
+    return bytes;
+}
+
+GameState UndoHistory::state(NodeId node) const {
+    if (node == currentNode) return currentState;
+    const Branch &branch = branches[branch_of(node)];
+    uint32_t index = index_of(node);
+    auto keyframe = std::upper_bound(branch.keyframes.begin(), branch.keyframes.end(), index,
+                                     [](uint32_t i, const std::pair<uint32_t, GameState> &k) { return i < k.first; });
+    --keyframe;
+    GameState s = keyframe->second;
+    for (uint32_t i = keyframe->first + 1; i <= index; ++i) s = decode_step(s, branch.codes[i]);
+    return s;
+}
+
+GameState UndoHistory::child_state(NodeId child, const GameState &parentState) const {
+    uint8_t code = branches[branch_of(child)].codes[index_of(child)];
+    return code == KEYFRAME ? state(child) : decode_step(parentState, code);
+}
+
+UndoHistory::NodeId UndoHistory::parent(NodeId node) const {
+    if (index_of(node) > 0) return node - 1;
+    return branches[branch_of(node)].parent;
+}
+
+UndoHistory::NodeId UndoHistory::default_child(NodeId node) const {
+    const Branch &branch = branches[branch_of(node)];
+    if (index_of(node) + 1 < branch.codes.size()) return node + 1;
+    for (uint32_t fork : branch.forks) {
+        if (branches[fork].parent == node) return make_node(fork, 0);
+    }
+    return NONE;
+}
+
+UndoHistory::NodeId UndoHistory::redo_child(NodeId node) const {
+    auto choice = redoChoices.find(node);
+    return choice != redoChoices.end() ? choice->second : default_child(node);
+}
+
+void UndoHistory::set_redo_child(NodeId node, NodeId child) {
+    if (child == default_child(node)) redoChoices.erase(node);
+    else redoChoices[node] = child;
+}
+
+std::vector<UndoHistory::NodeId> UndoHistory::children(NodeId node) const {
+    std::vector<NodeId> result;
+    NodeId redo = redo_child(node);
+    if (redo != NONE) result.push_back(redo);
+    const Branch &branch = branches[branch_of(node)];
+    if (index_of(node) + 1 < branch.codes.size() && node + 1 != redo) result.push_back(node + 1);
+    for (uint32_t fork : branch.forks) {
+        NodeId child = make_node(fork, 0);
+        if (branches[fork].parent == node && child != redo) result.push_back(child);
+    }
+    return result;
+}
+
+UndoHistory::NodeId UndoHistory::advance(GameState state) {
+    if (empty()) {
+        reset(state);
+        return currentNode;
+    }
+
+    for (NodeId child : children(currentNode)) {
+        GameState s = child_state(child, currentState);
+        if (s == state) {
+            set_redo_child(currentNode, child);
+            currentNode = child;
+            currentState = s;
+            return child;
+        }
+    }
+
+    uint32_t b = branch_of(currentNode);
+    NodeId child;
+    if (index_of(currentNode) + 1 == branches[b].codes.size()) {
+        // The current state ends its branch: extend it.
+        Branch &branch = branches[b];
+        auto index = (uint32_t)branch.codes.size();
+        uint8_t code;
+        if (index - branch.keyframes.back().first >= KEYFRAME_INTERVAL || !encode_step(currentState, state, &code)) {
+            code = KEYFRAME;
+            branch.keyframes.push_back({index, state});
+        }
+        branch.codes.push_back(code);
+        child = make_node(b, index);
+    } else {
+        auto fork = (uint32_t)branches.size();
+        branches.push_back({currentNode, (uint32_t)depth(currentNode) + 1, {KEYFRAME}, {{0, state}}, {}});
+        branches[b].forks.push_back(fork);
+        child = make_node(fork, 0);
+    }
+    stateCount++;
+    set_redo_child(currentNode, child);
+    currentNode = child;
+    currentState = state;
+    return child;
+}
+
+bool UndoHistory::undo() {
+    if (!can_undo()) return false;
+    NodeId p = parent(currentNode);
+    set_redo_child(p, currentNode);
+    currentState = state(p);
+    currentNode = p;
+    return true;
+}
+
+bool UndoHistory::redo() {
+    if (!can_redo()) return false;
+    NodeId child = redo_child(currentNode);
+    currentState = child_state(child, currentState);
+    currentNode = child;
+    return true;
+}
+
+void UndoHistory::jump(NodeId node) {
+    if (empty() || branch_of(node) >= branches.size() ||
+        index_of(node) >= branches[branch_of(node)].codes.size() || node == currentNode) {
+        return;
+    }
+    for (NodeId n = node, p; (p = parent(n)) != NONE; n = p) set_redo_child(p, n);
+    currentState = state(node);
+    currentNode = node;
+}
+
+UndoHistory::NodeId UndoHistory::ancestor(NodeId node, int d) const {
+    if (d < 0 || d > depth(node)) return NONE;
+    while ((int)branches[branch_of(node)].firstDepth > d) node = branches[branch_of(node)].parent;
+    return make_node(branch_of(node), d - branches[branch_of(node)].firstDepth);
+}
+
+UndoHistory::NodeId UndoHistory::common_ancestor(NodeId a, NodeId b) const {
+    // The deepest index on a's line of every branch that line goes through.
+    std::unordered_map<uint32_t, uint32_t> line;
+    for (NodeId n = a; n != NONE; n = branches[branch_of(n)].parent) line[branch_of(n)] = index_of(n);
+    for (NodeId n = b; n != NONE; n = branches[branch_of(n)].parent) {
+        auto found = line.find(branch_of(n));
+        if (found != line.end()) return make_node(found->first, std::min(found->second, index_of(n)));
+    }
+    return NONE;
+}
+
+UndoHistory::NodeId UndoHistory::branch_point(NodeId node) const {
+    while (node != NONE && children(node).size() < 2) node = parent(node);
+    return node;
+}
+
+UndoHistory::NodeId UndoHistory::line_end(NodeId node) const {
+    for (NodeId child; (child = redo_child(node)) != NONE; ) node = child;
+    return node;
+}
+
+// Layout: branch count, redo choice count, current node, then per branch
+// its parent, code count, keyframe count, codes and keyframes (index,
+// board, score, high), then the redo choices as node / child pairs. Forks
+// and depths follow from the parents.
+template <typename T>
+static void put_value(std::vector<uint8_t> &out, T value) {
+    size_t at = out.size();
+    out.resize(at + sizeof(T));
+    memcpy(out.data() + at, &value, sizeof(T));
+}
+
+template <typename T>
+static bool get_value(const uint8_t *&data, const uint8_t *end, T &value) {
+    if ((size_t)(end - data) < sizeof(T)) return false;
+    memcpy(&value, data, sizeof(T));
+    data += sizeof(T);
+    return true;
+}
+
+void UndoHistory::serialize(std::vector<uint8_t> &out) const {
+    put_value(out, (uint32_t)branches.size());
+    put_value(out, (uint32_t)redoChoices.size());
+    put_value(out, currentNode);
+    for (const Branch &branch : branches) {
+        put_value(out, branch.parent);
+        put_value(out, (uint32_t)branch.codes.size());
+        put_value(out, (uint32_t)branch.keyframes.size());
+        out.insert(out.end(), branch.codes.begin(), branch.codes.end());
+        for (const auto &keyframe : branch.keyframes) {
+            put_value(out, keyframe.first);
+            put_value(out, keyframe.second.board);
+            put_value(out, keyframe.second.score);
+            put_value(out, keyframe.second.high);
+        }
+    }
+    for (const auto &choice : redoChoices) {
+        put_value(out, choice.first);
+        put_value(out, choice.second);
+    }
+}
+
+bool UndoHistory::deserialize(const uint8_t *data, size_t size, bool withHigh) {
+    const uint8_t *end = data + size;
+    size_t keyframeSize = withHigh ? 28 : 20;
+    uint32_t branchCount, choiceCount;
+    NodeId current;
+    if (!get_value(data, end, branchCount) || !get_value(data, end, choiceCount) || !get_value(data, end, current) ||
+        branchCount == 0) {
+        return false;
+    }
+
+    UndoHistory loaded;
+    auto valid = [&loaded](NodeId node) {
+        return branch_of(node) < loaded.branches.size() &&
+               index_of(node) < loaded.branches[branch_of(node)].codes.size();
+    };
+    for (uint32_t b = 0; b < branchCount; ++b) {
+        Branch branch;
+        uint32_t codeCount, keyframeCount;
+        if (!get_value(data, end, branch.parent) || !get_value(data, end, codeCount) ||
+            !get_value(data, end, keyframeCount) || codeCount == 0 || keyframeCount == 0 ||
+            (size_t)(end - data) < codeCount + (size_t)keyframeCount * keyframeSize) {
+            return false;
+        }
+        // Only the first branch starts at the root; the others fork from
+        // a state of an earlier one.
+        if (b == 0 ? branch.parent != NONE : !valid(branch.parent)) return false;
+        branch.firstDepth = b == 0 ? 0 : (uint32_t)loaded.depth(branch.parent) + 1;
+        branch.codes.assign(data, data + codeCount);
+        data += codeCount;
+        uint32_t keyframeCodes = 0;
+        for (uint8_t code : branch.codes) {
+            if (code > KEYFRAME) return false;
+            keyframeCodes += code == KEYFRAME;
+        }
+        if (keyframeCodes != keyframeCount) return false;
+
+        branch.keyframes.resize(keyframeCount);
+        for (uint32_t k = 0; k < keyframeCount; ++k) {
+            auto &keyframe = branch.keyframes[k];
+            get_value(data, end, keyframe.first);
+            get_value(data, end, keyframe.second.board);
+            get_value(data, end, keyframe.second.score);
+            keyframe.second.high = 0;
+            if (withHigh) get_value(data, end, keyframe.second.high);
+            uint32_t previous = k == 0 ? 0 : branch.keyframes[k - 1].first;
+            if (keyframe.first >= codeCount || branch.codes[keyframe.first] != KEYFRAME ||
+                (k == 0 ? keyframe.first != 0 : keyframe.first <= previous)) {
+                return false;
+            }
+        }
+        if (b > 0) loaded.branches[branch_of(branch.parent)].forks.push_back(b);
+        loaded.stateCount += codeCount;
+        loaded.branches.push_back(std::move(branch));
+    }
+
+    for (uint32_t i = 0; i < choiceCount; ++i) {
+        NodeId node, child;
+        if (!get_value(data, end, node) || !get_value(data, end, child) || !valid(node) || !valid(child) ||
+            loaded.parent(child) != node) {
+            return false;
+        }
+        loaded.redoChoices[node] = child;
+    }
+    if (data != end || !valid(current)) return false;
+
+    loaded.currentState = loaded.state(current);
+    loaded.currentNode = current;
+    *this = std::move(loaded);
+    return true;
+}
@@ -0,0 +1,127 @@
+//
+// Created by Rache on 2026/10/17.
+//
+
+#ifndef INC_2048GAME_UNDOHISTORY_H
+#define INC_2048GAME_UNDOHISTORY_H
+
+#include <cstddef>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "GameEngine.h"
+
+// `high` is GameEngine::high, 0 until a tile goes past MAX_TILE_EXPONENT.
+struct GameState {
+    Board board;
+    int64_t score;
+    Board high = 0;
+
+    WideBoard wide_board() const { return {board, high}; }
+    bool operator==(const GameState &other) const {
+        return board == other.board && score == other.score && high == other.high;
+    }
+    bool operator!=(const GameState &other) const { return !(*this == other); }
+};
+
+// A state that is one move plus one spawn away from `from` packs into one
+// byte (direction, spawn cell, 2 or 4); its score follows from the move.
+bool encode_step(const GameState &from, const GameState &to, uint8_t *code);
+GameState decode_step(const GameState &from, uint8_t code);
+
+// Undo / redo history as a tree of game states. Undoing and then playing
+// another move starts a branch next to the old line instead of dropping
+// it. Branches share every state up to where they split, and playing into
+// a state the current one already leads to reuses that node, so memory
+// only grows with the number of distinct states.
+//
+// The tree is stored as branches, runs of states each following the one
+// before. A state is one step code byte; the first state of a branch,
+// every KEYFRAME_INTERVAL-th state and any state that is not one step away
+// from the one before it (e.g. after a run_cmd edit) are kept in full on
+// the side. A long game costs about 1.3 bytes per move.
+//
+// state() replays at most KEYFRAME_INTERVAL - 1 steps from the nearest
+// full state. The current state is cached, so advance, undo and redo are
+// O(1). Redo follows the child visited last.
+class UndoHistory {
+public:
+    // Branch index in the high 32 bits, index in the branch in the low ones.
+    typedef uint64_t NodeId;
+    static const NodeId NONE = ~0ULL;
+    static const int KEYFRAME_INTERVAL = 64;
+
+    // Drops every node; `root` becomes the current state.
+    void reset(GameState root);
+    bool empty() const { return branches.empty(); }
+    size_t size() const { return stateCount; }
+    size_t branch_count() const { return branches.size(); }
+    // Approximate heap bytes in use.
+    size_t memory_usage() const;
+
+    NodeId current() const { return currentNode; }
+    const GameState &current_state() const { return currentState; }
+    GameState state(NodeId node) const;
+
+    // Moves to the child of the current node holding `state`, adding it
+    // when there is none yet.
+    NodeId advance(GameState state);
+    bool can_undo() const { return !empty() && parent(currentNode) != NONE; }
+    bool undo();
+    bool can_redo() const { return !empty() && redo_child(currentNode) != NONE; }
+    bool redo();
+    // Makes `node` current, and the line leading to it the redo line.
+    void jump(NodeId node);
+
+    NodeId parent(NodeId node) const;
+    // The redo child first, then the others.
+    std::vector<NodeId> children(NodeId node) const;
+    // Number of moves from the root.
+    int depth(NodeId node) const { return (int)(branches[branch_of(node)].firstDepth + index_of(node)); }
+    // The node on the line from the root to `node` at the given depth.
+    NodeId ancestor(NodeId node, int depth) const;
+    // Where the lines to a and b split, for comparing branches.
+    NodeId common_ancestor(NodeId a, NodeId b) const;
+    // The nearest node at or above `node` with more than one child.
+    NodeId branch_point(NodeId node) const;
+    // Where redoing from `node` as far as possible ends.
+    NodeId line_end(NodeId node) const;
+
+    // The whole tree as bytes, for save files; native byte order.
+    void serialize(std::vector<uint8_t> &out) const;
+    // Rebuilds the tree from serialize()'s bytes. Returns false and leaves
+    // the history alone when they do not describe a valid tree. Trees
+    // serialized before boards had a high half have keyframes without it;
+    // read those with `withHigh` false.
+    bool deserialize(const uint8_t *data, size_t size, bool withHigh = true);
+
+private:
+    static const uint8_t KEYFRAME = 0x80;
+
+    struct Branch {
+        NodeId parent;                  // node the first state follows; NONE for the root
+        uint32_t firstDepth;
+        std::vector<uint8_t> codes;     // step code per state, or KEYFRAME
+        std::vector<std::pair<uint32_t, GameState>> keyframes;  // by index
+        std::vector<uint32_t> forks;    // branches whose parent is one of our states
+    };
+
+    static NodeId make_node(uint32_t branch, uint32_t index) { return (NodeId)branch << 32 | index; }
+    static uint32_t branch_of(NodeId node) { return (uint32_t)(node >> 32); }
+    static uint32_t index_of(NodeId node) { return (uint32_t)node; }
+
+    NodeId default_child(NodeId node) const;
+    NodeId redo_child(NodeId node) const;
+    void set_redo_child(NodeId node, NodeId child);
+    GameState child_state(NodeId child, const GameState &parentState) const;
+
+    std::vector<Branch> branches;
+    // Redo choices that differ from default_child.
+    std::unordered_map<NodeId, NodeId> redoChoices;
+    size_t stateCount = 0;
+    NodeId currentNode = NONE;
+    GameState currentState{0, 0};
+};
+
+
+#endif //INC_2048GAME_UNDOHISTORY_H
@@ -0,0 +1,184 @@
+//
+// Created by Rache on 2026/10/17.
+//
+// Re-plays submitted replay journals with the headless rules on every core
+// and prints a pass/fail line per journal, then a summary.
+//
+// usage: 2048Verify [-t threads] [-m manifest] [-o report] [journal...]
+//
+// A manifest lists one submission per line, "<journal> <claimed score>";
+// "-m -" reads it from standard input. Journals given on the command line
+// have no claimed score, so only their play is checked.
+//
+// A journal passes when every spawn in it is the one the recorded seed's
+// generator makes, it never jumps to another state (undo, edits), its
+// keyframes agree with the replayed game, it reaches its end record, and
+// the final score equals the claimed one.
+//
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cinttypes>
+#include <chrono>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "ReplayJournal.h"
+#include "ThreadPool.h"
+
+struct Submission {
+    std::string path;
+    bool claimed = false;
+    int64_t claimedScore = 0;
+};
+
+struct Verdict {
+    bool passed = false;
+    uint64_t moves = 0;
+    int64_t score = 0;
+    int maxTile = 0;
+    std::string reason;
+};
+
+struct VerifyOptions {
+    int threads = 0;
+    std::string manifest;
+    std::string report;
+    std::vector<Submission> submissions;
+};
+
+static Verdict verify(const Submission &submission) {
+    Verdict verdict;
+    ReplayReader reader;
+    if (!reader.open(submission.path)) {
+        verdict.reason = "not a replay journal";
+        return verdict;
+    }
+
+    GameEngine game;
+    reader.start(game);
+    while (reader.next(game)) {}
+    verdict.moves = reader.move_count();
+    verdict.score = game.score;
+    verdict.maxTile = game.max_tile();
+
+    char reason[128] = "";
+    if (reader.error()) {
+        snprintf(reason, sizeof(reason), "move %" PRIu64 " does not apply", reader.move_count());
+    } else if (!reader.complete()) {
+        snprintf(reason, sizeof(reason), "cut short after %" PRIu64 " moves", reader.move_count());
+    } else if (reader.explicit_spawns() > 0) {
+        snprintf(reason, sizeof(reason), "%" PRIu64 " spawns not from the seed", reader.explicit_spawns());
+    } else if (reader.jumps() > 0) {
+        snprintf(reason, sizeof(reason), "%" PRIu64 " jumps to another state", reader.jumps());
+    } else if (reader.keyframe_mismatches() > 0) {
+        snprintf(reason, sizeof(reason), "%" PRIu64 " keyframes disagree", reader.keyframe_mismatches());
+    } else if (reader.move_count() != reader.total_moves()) {
+        snprintf(reason, sizeof(reason), "index claims %" PRIu64 " moves", reader.total_moves());
+    } else if (submission.claimed && game.score != submission.claimedScore) {
+        snprintf(reason, sizeof(reason), "claimed score %" PRId64, submission.claimedScore);
+    }
+    verdict.reason = reason;
+    verdict.passed = verdict.reason.empty();
+    return verdict;
+}
+
+static bool read_manifest(const std::string &path, std::vector<Submission> &submissions) {
+    FILE *f = path == "-" ? stdin : fopen(path.c_str(), "r");
+    if (!f) return false;
+    char line[4096];
+    while (fgets(line, sizeof(line), f)) {
+        char *end = line + strlen(line);
+        while (end > line && (end[-1] == '\n' || end[-1] == '\r' || end[-1] == ' ' || end[-1] == '\t')) *--end = 0;
+        if (line[0] == 0 || line[0] == '#') continue;
+        // The score is the last field, so paths may hold spaces.
+        Submission submission;
+        char *space = strrchr(line, ' ');
+        char *tab = strrchr(line, '\t');
+        if (tab > space) space = tab;
+        char *scoreEnd = nullptr;
+        if (space) submission.claimedScore = strtoll(space + 1, &scoreEnd, 10);
+        if (space && scoreEnd != space + 1 && *scoreEnd == 0) {
+            submission.claimed = true;
+            *space = 0;
+        }
+        submission.path = line;
+        submissions.push_back(submission);
+    }
+    if (f != stdin) fclose(f);
+    return true;
+}
+
+static bool parse_options(int argc, char *argv[], VerifyOptions &options) {
+    for (int i = 1; i < argc; ++i) {
+        if (argv[i][0] != '-' || argv[i][1] == 0) {
+            Submission submission;
+            submission.path = argv[i];
+            options.submissions.push_back(submission);
+            continue;
+        }
+        if (i + 1 >= argc) return false;
+        const char *value = argv[++i];
+        if (strcmp(argv[i - 1], "-t") == 0) options.threads = atoi(value);
+        else if (strcmp(argv[i - 1], "-m") == 0) options.manifest = value;
+        else if (strcmp(argv[i - 1], "-o") == 0) options.report = value;
+        else return false;
+    }
+    return !options.submissions.empty() || !options.manifest.empty();
+}
+
+int main(int argc, char *argv[]) {
+    VerifyOptions options;
+    if (!parse_options(argc, argv, options)) {
+        fprintf(stderr, "usage: %s [-t threads] [-m manifest] [-o report] [journal...]\n", argv[0]);
+        return 2;
+    }
+    if (!options.manifest.empty() && !read_manifest(options.manifest, options.submissions)) {
+        fprintf(stderr, "cannot read %s\n", options.manifest.c_str());
+        return 2;
+    }
+    FILE *report = options.report.empty() ? stdout : fopen(options.report.c_str(), "w");
+    if (!report) {
+        fprintf(stderr, "cannot write %s\n", options.report.c_str());
+        return 2;
+    }
+
+    const std::vector<Submission> &submissions = options.submissions;
+    std::vector<Verdict> verdicts(submissions.size());
+    ThreadPool pool(options.threads);
+    std::atomic<size_t> nextSubmission{0};
+
+    // One task per worker pulling journals off a shared counter keeps the
+    // scheduling cost per journal at one atomic add.
+    auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < pool.size(); ++t) {
+        pool.submit([&submissions, &verdicts, &nextSubmission] {
+            for (size_t i; (i = nextSubmission.fetch_add(1)) < submissions.size(); ) {
+                verdicts[i] = verify(submissions[i]);
+            }
+        });
+    }
+    pool.wait();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    uint64_t passed = 0, moves = 0;
+    for (size_t i = 0; i < submissions.size(); ++i) {
+        const Verdict &v = verdicts[i];
+        char claim[32] = "-";
+        if (submissions[i].claimed) snprintf(claim, sizeof(claim), "%" PRId64, submissions[i].claimedScore);
+        fprintf(report, "%s  %s  moves %" PRIu64 "  score %" PRId64 "  claimed %s  max %" PRIu64 "%s%s\n",
+                v.passed ? "PASS" : "FAIL", submissions[i].path.c_str(), v.moves, v.score, claim,
+                v.maxTile ? (uint64_t)1 << v.maxTile : 0, v.passed ? "" : "  ", v.reason.c_str());
+        passed += v.passed;
+        moves += v.moves;
+    }
+    if (report != stdout) fclose(report);
+
+    fprintf(stderr, "verified %zu journals in %.2f s on %d threads: %" PRIu64 " passed, %" PRIu64 " failed\n",
+            submissions.size(), seconds, pool.size(), passed, (uint64_t)submissions.size() - passed);
+    fprintf(stderr, "%.0f moves/s, %.0f moves/s per thread\n", moves / seconds, moves / seconds / pool.size());
+    return passed == submissions.size() ? 0 : 1;
+}
@@ -8,6 +8,9 @@ int main(int argc, char *argv[])
     QGuiApplication::setHighDpiScaleFactorRoundingPolicy(Qt::HighDpiScaleFactorRoundingPolicy::PassThrough);
     QApplication a(argc, argv);
     QApplication::setStyle("Fusion");
+    // Map the row tables instead of building them; the first run writes them.
+    std::string rowTablePath = (QCoreApplication::applicationDirPath() + "/row_tables.bin").toStdString();
+    if (!load_row_tables(rowTablePath)) save_row_tables(rowTablePath);
 #ifdef _WIN32
     a.setStyleSheet("QPushButton, QLabel, QLineEdit{font-family: Microsoft YaHei}");
 #endif
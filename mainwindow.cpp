@@ -11,38 +11,53 @@
 #include <QSettings>
 #include <QTextCodec>
 #include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
 
 #include <iostream>
 #include <ctime>
-#include <fstream>
 
 #include <QDebug>
 
 #define UNDO_COUNT_TEXT "撤销次数："+QString::number(undoCount)
+#define FOUR_BY_FOUR_ONLY_TEXT "AI、回放和存档只支持4x4棋盘。"
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
 {
     gameArea = new GameArea;
+    replayScrubber = new ReplayScrubber;
     newGameButton = new QPushButton("新游戏");
     nameLabel = new QLabel("2048");
     scoreLabel = new QLabel("0");
     undoCountLabel = new QLabel("撤销次数：0");
+    turboLabel = new QLabel;
     newGameAction = new QAction("新游戏");
     openAction = new QAction("打开");
+    openReplayAction = new QAction("打开回放");
     saveAction = new QAction("保存");
     saveAsAction = new QAction("另存为");
     cmdAction = new QAction("指令");
     helpCmdAction = new QAction("指令帮助");
     undoAction = new QAction("撤销");
+    redoAction = new QAction("重做");
     undoLockAction = new QAction("锁定撤销");
+    hintAction = new QAction("提示");
+    autoplayAction = new QAction("自动游戏");
+    turboAction = new QAction("极速自动游戏");
     loadSettingsAction = new QAction("加载配置文件");
     updateContentAction = new QAction("更新内容");
     aboutQtAction = new QAction("关于Qt");
     aboutMeAction = new QAction("关于作者");
-    memset(numbers, 0, sizeof(numbers));
+    boardSizeGroup = new QActionGroup(this);
 
-    randomEngine.seed(time(nullptr));
+    game.random.seed(time(nullptr));
+    ai.depth = 8;
+    ai.threads = ThreadPool::hardware_threads();
+    autoplayTimer.setInterval(200);
+    turboTimer.setInterval(1000 / 60);
+    autosaveTimer.setSingleShot(true);
+    autosaveTimer.setInterval(1000);
 
     init_settings();
     init_ui();
@@ -50,24 +65,50 @@ MainWindow::MainWindow(QWidget *parent)
     connect(newGameButton, SIGNAL(clicked()), this, SLOT(new_game()));
     connect(newGameAction, SIGNAL(triggered()), this, SLOT(new_game()));
     connect(openAction, SIGNAL(triggered()), this, SLOT(open()));
+    connect(openReplayAction, SIGNAL(triggered()), this, SLOT(open_replay()));
+    connect(replayScrubber, SIGNAL(position_changed(int)), this, SLOT(replay_seek(int)));
+    connect(replayScrubber->exitButton, SIGNAL(clicked()), this, SLOT(close_replay()));
     connect(saveAction, SIGNAL(triggered()), this, SLOT(save()));
     connect(saveAsAction, SIGNAL(triggered()), this, SLOT(save_as()));
     connect(cmdAction, SIGNAL(triggered()), this, SLOT(run_cmd()));
     connect(helpCmdAction, SIGNAL(triggered()), this, SLOT(show_cmd_help()));
     connect(undoAction, SIGNAL(triggered()), this, SLOT(undo()));
+    connect(redoAction, SIGNAL(triggered()), this, SLOT(redo()));
     connect(undoLockAction, SIGNAL(triggered(bool)), this, SLOT(set_undo_lock(bool)));
+    connect(hintAction, SIGNAL(triggered()), this, SLOT(hint()));
+    connect(autoplayAction, SIGNAL(triggered(bool)), this, SLOT(set_autoplay(bool)));
+    connect(&autoplayTimer, SIGNAL(timeout()), this, SLOT(autoplayTimer_timeout()));
+    connect(turboAction, SIGNAL(triggered(bool)), this, SLOT(set_turbo(bool)));
+    connect(&turboTimer, SIGNAL(timeout()), this, SLOT(turboTimer_timeout()));
+    connect(&autosaveTimer, SIGNAL(timeout()), this, SLOT(autosave()));
     connect(loadSettingsAction, SIGNAL(triggered()), this, SLOT(loadSettingsAction_triggered()));
     connect(updateContentAction, SIGNAL(triggered()), this, SLOT(show_update_content()));
     connect(aboutQtAction, SIGNAL(triggered()), this, SLOT(about_qt()));
     connect(aboutMeAction, SIGNAL(triggered()), this, SLOT(about_me()));
-
-    new_game();
+    connect(boardSizeGroup, SIGNAL(triggered(QAction*)), this, SLOT(boardSizeAction_triggered(QAction*)));
+
+    // Carry on from where the last session left off.
+    autosaver.reset(new AutoSaver((QCoreApplication::applicationDirPath() + "/autosave.2048game").toLocal8Bit().toStdString()));
+    SavedGame saved;
+    UndoHistory loaded;
+    SaveFormat format = read_saved_game(autosaver->path(), saved, loaded);
+    if (format != SaveFormat::Invalid) {
+        show_saved_game(saved, loaded, format);
+    } else {
+        new_game();
+    }
 
     setFocusPolicy(Qt::StrongFocus);
 }
 
-MainWindow::~MainWindow()
-= default;
+MainWindow::~MainWindow() {
+    if (searchThread.joinable()) searchThread.join();
+    turbo.stop();
+    // Hand over what the timer has not saved yet; the autosaver writes it
+    // before its thread stops.
+    if (autosaveTimer.isActive()) autosave();
+    autosaver.reset();
+}
 
 void MainWindow::init_ui() {
     setFixedWidth(gameArea->frameSize + 20);
@@ -108,6 +149,7 @@ void MainWindow::init_ui() {
 
     auto widgetMainLayout = new QVBoxLayout;
     widgetMainLayout->addLayout(titleLayout);
+    widgetMainLayout->addWidget(replayScrubber);
     widgetMainLayout->addWidget(gameArea);
     widgetMainLayout->addStretch(0);
     widgetMainLayout->setContentsMargins(10, 5, 10, 5);
@@ -118,6 +160,7 @@ void MainWindow::init_ui() {
     auto fileMenu = menuBar()->addMenu("文件");
     fileMenu->addAction(newGameAction);
     fileMenu->addAction(openAction);
+    fileMenu->addAction(openReplayAction);
     fileMenu->addAction(saveAction);
     fileMenu->addAction(saveAsAction);
     newGameAction->setShortcut(QKeySequence::New);
@@ -129,42 +172,47 @@ void MainWindow::init_ui() {
     operMenu->addAction(cmdAction);
     operMenu->addAction(helpCmdAction);
     operMenu->addAction(undoAction);
+    operMenu->addAction(redoAction);
     operMenu->addAction(undoLockAction);
     cmdAction->setShortcut(QKeySequence("Ctrl+R"));
     undoAction->setShortcut(QKeySequence::Undo);
+    redoAction->setShortcut(QKeySequence::Redo);
     undoLockAction->setCheckable(true);
+    operMenu->addAction(hintAction);
+    operMenu->addAction(autoplayAction);
+    operMenu->addAction(turboAction);
+    hintAction->setShortcut(QKeySequence("Ctrl+H"));
+    autoplayAction->setShortcut(QKeySequence("Ctrl+P"));
+    autoplayAction->setCheckable(true);
+    turboAction->setShortcut(QKeySequence("Ctrl+Shift+P"));
+    turboAction->setCheckable(true);
     operMenu->addAction(loadSettingsAction);
 
+    auto boardSizeMenu = operMenu->addMenu("棋盘大小");
+    for (int size = MIN_BOARD_SIZE; size <= MAX_BOARD_SIZE; ++size) {
+        auto *action = new QAction(QString::number(size) + "x" + QString::number(size));
+        action->setData(size);
+        action->setCheckable(true);
+        action->setChecked(size == cellCount);
+        boardSizeGroup->addAction(action);
+        boardSizeMenu->addAction(action);
+    }
+
     auto aboutMenu = menuBar()->addMenu("关于");
     aboutMenu->addAction(updateContentAction);
     aboutMenu->addAction(aboutQtAction);
     aboutMenu->addAction(aboutMeAction);
 
+    statusBar()->addPermanentWidget(turboLabel);
     statusBar()->addPermanentWidget(undoCountLabel);
+    turboLabel->hide();
 }
 
 void MainWindow::random_spawn_number() {
-    int emptyCells[cellCount * cellCount][2];
-    int emptyCount = 0;
-    for (int row = 0; row < cellCount; ++row) {
-        for (int column = 0; column < cellCount; ++column) {
-            if (numbers[row][column] == 0) {
-                emptyCells[emptyCount][0] = row;
-                emptyCells[emptyCount][1] = column;
-                emptyCount++;
-            }
-        }
+    int row, column, number;
+    if (grid_mode() ? grid.spawn(&row, &column, &number) : game.spawn(&row, &column, &number)) {
+        gameArea->add_spawn_animation(row, column, number);
     }
-    if (emptyCount == 0) return;
-    unsigned int randomIndex = std::uniform_int_distribution<unsigned>(0, emptyCount - 1)(randomEngine);
-    int randomNumber;
-    if (std::bernoulli_distribution(0.9)(randomEngine)) {
-        randomNumber = 1;
-    } else {
-        randomNumber = 2;
-    }
-    numbers[emptyCells[randomIndex][0]][emptyCells[randomIndex][1]] = randomNumber;
-    gameArea->add_spawn_animation(emptyCells[randomIndex][0], emptyCells[randomIndex][1], randomNumber);
 }
 
 void MainWindow::keyPressEvent(QKeyEvent *event) {
@@ -180,210 +228,125 @@ void MainWindow::keyPressEvent(QKeyEvent *event) {
             left();
         } else if (key == Qt::Key_Right or key == Qt::Key_D) {
             right();
+        } else if (key == Qt::Key_H) {
+            hint();
         }
     // output();
     QWidget::keyPressEvent(event);
 }
 
 void MainWindow::up() {
-    gameArea->stop_animation();
-    memset(isSpan, 0, sizeof(isSpan));
-    NumbersStep step{};
-    step.score = score;
-    memcpy(step.numbers, numbers, sizeof(numbers));
-
-    bool flag = false;
-    for (int row = 1; row < cellCount; ++row) {
-        for (int column = 0; column < cellCount; ++column) {
-            if (numbers[row][column] == 0) continue;
-
-            int tr = row - 1;
-            for (; tr >= 0; --tr) if (numbers[tr][column] != 0) break;
-
-            if (tr == -1) {
-                flag = true;
-                move_number(row, column, 0, column);
-            } else if (try_span(row, column, tr, column)) {
-                flag = true;
-            } else {
-                tr++;
-                if (tr != row) {
-                    move_number(row, column, tr, column);
-                    flag = true;
-                }
-            }
-        }
-    }
-    if (flag) {
-        push_to_stack(step);
-        random_spawn_number();
-        gameArea->start_animation();
-    }
+    play_move(Direction::Up);
 }
 
 void MainWindow::down() {
-    gameArea->stop_animation();
-    memset(isSpan, 0, sizeof(isSpan));
-    NumbersStep step{};
-    step.score = score;
-    memcpy(step.numbers, numbers, sizeof(numbers));
-
-    bool flag = false;
-    for (int row = cellCount - 2; row >= 0; --row)
-        for (int column = 0; column < cellCount; ++column) {
-            if (numbers[row][column] == 0) continue;
-
-            int tr = row + 1;
-            for (; tr < cellCount; ++tr) if (numbers[tr][column] != 0) break;
-
-            if (tr == cellCount) {
-                flag = true;
-                move_number(row, column, cellCount - 1, column);
-            } else if (try_span(row, column, tr, column)) {
-                flag = true;
-            } else {
-                tr--;
-                if (tr != row) {
-                    move_number(row, column, tr, column);
-                    flag = true;
-                }
-            }
-        }
-    if (flag) {
-        push_to_stack(step);
-        random_spawn_number();
-        gameArea->start_animation();
-    }
+    play_move(Direction::Down);
 }
 
 void MainWindow::left() {
-    gameArea->stop_animation();
-    memset(isSpan, 0, sizeof(isSpan));
-    NumbersStep step{};
-    step.score = score;
-    memcpy(step.numbers, numbers, sizeof(numbers));
-
-    bool flag = false;
-    for (int column = 1; column < cellCount; ++column) {
-        for (int row = 0; row < cellCount; ++row) {
-            if (numbers[row][column] == 0) continue;
-
-            int tc = column - 1;
-            for (; tc >= 0; --tc) if (numbers[row][tc] != 0) break;
-
-            if (tc == -1) {
-                move_number(row, column, row, 0);
-                flag = true;
-            } else if (try_span(row, column, row, tc)) {
-                flag = true;
-            } else {
-                tc++;
-                if (tc != column) {
-                    move_number(row, column, row, tc);
-                    flag = true;
-                }
-            }
-        }
-    }
-    if (flag) {
-        push_to_stack(step);
-        random_spawn_number();
-        gameArea->start_animation();
-    }
+    play_move(Direction::Left);
 }
 
 void MainWindow::right() {
-    gameArea->stop_animation();
-    memset(isSpan, 0, sizeof(isSpan));
-    NumbersStep step{};
-    step.score = score;
-    memcpy(step.numbers, numbers, sizeof(numbers));
-
-    bool flag = false;
-    for (int column = cellCount - 2; column >= 0; --column) {
-        for (int row = 0; row < cellCount; ++row) {
-            if (numbers[row][column] == 0) continue;
-
-            int tc = column + 1;
-            for (; tc < cellCount; ++tc) if (numbers[row][tc] != 0) break;
-            if (tc == cellCount) {
-                move_number(row, column, row, cellCount - 1);
-                flag = true;
-            } else if (try_span(row, column, row, tc)) {
-                flag = true;
-            } else {
-                tc--;
-                if (tc != column) {
-                    move_number(row, column, row, tc);
-                    flag = true;
-                }
-            }
-        }
-    }
-
-    if (flag) {
-        push_to_stack(step);
-        random_spawn_number();
-        gameArea->start_animation();
-    }
+    play_move(Direction::Right);
 }
 
-void MainWindow::output() {
-    for (auto & number : numbers) {
-        for (int j : number) {
-            printf("%5d ", j);
-        }
-        printf("\n");
+void MainWindow::play_move(Direction d) {
+    if (replayMode) close_replay();
+    // Keys arriving mid animation are played at once; the running animation
+    // jumps to its end and this move animates faster instead.
+    gameArea->finish_animation();
+    if (grid_mode()) {
+        play_grid_move(d);
+        return;
     }
+    GameState step{game.board, game.score, game.high};
+
+    MoveTrace trace;
+    if (!game.move(d, &trace)) return;
+    journal.record_move(d, game);
+    journal.flush();
+
+    show_move(trace);
+    scoreLabel->setText(QString::number(game.score));
+    push_to_history(step);
+    schedule_autosave();
+    gameArea->start_animation();
 }
 
-void MainWindow::spawn_number_without_animation(int row, int column, int number) {
-    numbers[row][column] = number;
-    gameArea->data[row][column] = number;
-    gameArea->update();
+void MainWindow::play_grid_move(Direction d) {
+    GridState step{grid.board, grid.score};
+    MoveTrace trace;
+    if (!grid.move(d, &trace)) return;
+    gridUndo.push_back(step);
+    gridRedo.clear();
+    undoAction->setEnabled(true);
+    redoAction->setEnabled(false);
+
+    show_move(trace);
+    scoreLabel->setText(QString::number(grid.score));
+    gameArea->start_animation();
 }
 
-bool MainWindow::try_span(int fr, int fc, int tr, int tc) {
-    if (isSpan[tr][tc]) return false;
-    if (numbers[fr][fc] == numbers[tr][tc]) {
-        gameArea->add_move_animation(fr, fc, tr, tc, numbers[fr][fc]);
-        int n = ++numbers[tr][tc];
-        numbers[fr][fc] = 0;
-        gameArea->add_spawn_animation(tr, tc, n);
-        isSpan[tr][tc] = true;
-        score += 1 << n;
-        scoreLabel->setText(QString::number(score));
-        if (first2048 and n == 11) {
+// Queues the animations of a move made with a trace.
+void MainWindow::show_move(const MoveTrace &trace) {
+    for (int i = 0; i < trace.tileCount; ++i) {
+        const TileMove &tile = trace.tiles[i];
+        gameArea->add_move_animation(tile.fr, tile.fc, tile.tr, tile.tc, tile.number);
+        if (tile.merged == 0) continue;
+
+        gameArea->add_spawn_animation(tile.tr, tile.tc, tile.merged);
+        if (first2048 and tile.merged == 11) {
             first2048 = false;
             gameArea->play_win_animation();
-        } else if (n == 17) {
-            gameArea->play_end_animation(tr, tc);
+        } else if (tile.merged == 17) {
+            gameArea->play_end_animation(tile.tr, tile.tc);
         }
-        return true;
     }
-    return false;
+    if (trace.spawnNumber != 0) {
+        gameArea->add_spawn_animation(trace.spawnRow, trace.spawnColumn, trace.spawnNumber);
+    }
 }
 
-void MainWindow::move_number(int fr, int fc, int tr, int tc) {
-    int n = numbers[fr][fc];
-    numbers[tr][tc] = n;
-    numbers[fr][fc] = 0;
-    gameArea->add_move_animation(fr, fc, tr, tc, n);
+void MainWindow::output() {
+    for (int i = 0; i < cellCount; ++i) {
+        for (int j = 0; j < cellCount; ++j) {
+            printf("%5d ", board_cell(i, j));
+        }
+        printf("\n");
+    }
+}
+
+void MainWindow::spawn_number_without_animation(int row, int column, int number) {
+    if (grid_mode()) {
+        grid.set(row, column, number);
+    } else {
+        game.set(row, column, number);
+    }
+    gameArea->data[row][column] = board_cell(row, column);
+    gameArea->update();
 }
 
 void MainWindow::new_game() {
+    replayMode = false;
+    replayScrubber->hide();
     gameArea->clear();
-    memset(numbers, 0, sizeof(numbers));
-    score = 0;
+    if (!grid_mode()) start_journal();
+    game.clear();
+    grid.clear();
     scoreLabel->setText("0");
-    undoAction->setEnabled(false);
     undoCount = 0;
     undoCountLabel->setText("撤销次数：0");
-    undoStack.clear();
     first2048 = true;
 
     random_spawn_number();
     random_spawn_number();
+    history.reset({game.board, game.score, game.high});
+    gridUndo.clear();
+    gridRedo.clear();
+    undoAction->setEnabled(false);
+    redoAction->setEnabled(false);
+    schedule_autosave();
     gameArea->start_animation();
 }
 
@@ -410,7 +373,7 @@ void MainWindow::run_cmd() {
                 QMessageBox::warning(this, "无效指令", "无效参数column：" + QString::number(column));
                 return;
             }
-            if (number >= 18 or number < 0) {
+            if (number > MAX_WIDE_TILE_EXPONENT or number < 0) {
                 QMessageBox::warning(this, "无效指令", "无效参数number：" + QString::number(number));
                 return;
             }
@@ -421,7 +384,7 @@ void MainWindow::run_cmd() {
         if (ok) {
             int s = args.toInt(&ok);
             if (ok) {
-                score = s;
+                game_score() = s;
                 scoreLabel->setText(QString::number(s));
             } else {
                 QMessageBox::warning(this, "无效指令", "无效参数score：" + args);
@@ -440,23 +403,23 @@ void MainWindow::run_cmd() {
         if (!ok) return;
         int sr, sc, er, ec, n;
         sscanf(args.toStdString().c_str(), "%d %d %d %d %d", &sr, &sc, &er, &ec, &n);
-        if (sr < 0 or sr > 4) {
+        if (sr < 0 or sr > cellCount) {
             QMessageBox::warning(this, "无效指令", "无效参数sr：" + QString::number(sr));
             return;
         }
-        if (sc < 0 or sc > 4) {
+        if (sc < 0 or sc > cellCount) {
             QMessageBox::warning(this, "无效指令", "无效参数sc：" + QString::number(sc));
             return;
         }
-        if (er < 0 or er > 4) {
+        if (er < 0 or er > cellCount) {
             QMessageBox::warning(this, "无效指令", "无效参数er：" + QString::number(er));
             return;
         }
-        if (ec < 0 or ec > 4) {
+        if (ec < 0 or ec > cellCount) {
             QMessageBox::warning(this, "无效指令", "无效参数ec：" + QString::number(ec));
             return;
         }
-        if (n >= 18 or n < 0) {
+        if (n > MAX_WIDE_TILE_EXPONENT or n < 0) {
             QMessageBox::warning(this, "无效指令", "无效参数n：" + QString::number(n));
             return;
         }
@@ -466,13 +429,14 @@ void MainWindow::run_cmd() {
         if (ok) {
             int seed = args.toInt(&ok);
             if (ok) {
-                randomEngine.seed(seed);
+                game.random.seed(seed);
+                grid.random.seed(seed);
             }
         }
     } else if (cmdName == "end"){
         int n = 1;
-        for (int i = 0; i < 4; ++i) {
-            for (int j = 0; j < 4; ++j) {
+        for (int i = 0; i < cellCount; ++i) {
+            for (int j = 0; j < cellCount; ++j) {
                 spawn_number_without_animation(i , j, n++);
             }
         }
@@ -481,15 +445,15 @@ void MainWindow::run_cmd() {
     } else if (cmdName == "about_me") {
         about_me();
     } else if (cmdName == "f2048") {
-        fill_number(0, 0, 4, 4, 11);
+        fill_number(0, 0, cellCount, cellCount, 11);
     } else if (cmdName == "f2") {
-        fill_number(0, 0, 4, 4, 1);
+        fill_number(0, 0, cellCount, cellCount, 1);
     } else if (cmdName == "clear") {
-        fill_number(0, 0, 4, 4, 0);
+        fill_number(0, 0, cellCount, cellCount, 0);
     } else if (cmdName == "f8192") {
-        fill_number(0, 0, 4, 4, 13);
+        fill_number(0, 0, cellCount, cellCount, 13);
     } else if (cmdName == "f131072") {
-        fill_number(0, 0, 4, 4, 17);
+        fill_number(0, 0, cellCount, cellCount, 17);
     } else if (cmdName == "get_max") {
         QMessageBox::information(this, "最大值", commandGetMaxText);
     } else if (cmdName == "THANKS") {
@@ -498,8 +462,131 @@ void MainWindow::run_cmd() {
         gameArea->play_end_animation(0, 0);
     } else if (cmdName == "play_win_animation") {
         gameArea->play_win_animation();
+    } else if (cmdName == "hint") {
+        hint();
+    } else if (cmdName == "autoplay") {
+        set_autoplay(!autoplayTimer.isActive());
+    } else if (cmdName == "turbo") {
+        set_turbo(!turboTimer.isActive());
+    } else if (cmdName == "set_size") {
+        QString args = QInputDialog::getText(this, "参数", "输入set_size的参数\n int size", QLineEdit::Normal, "", &ok);
+        if (ok) {
+            int size = args.toInt(&ok);
+            if (ok and size >= MIN_BOARD_SIZE and size <= MAX_BOARD_SIZE) {
+                set_board_size(size);
+            } else {
+                QMessageBox::warning(this, "无效指令", "无效参数size：" + args);
+            }
+        }
+    } else if (cmdName == "set_turbo_depth") {
+        QString args = QInputDialog::getText(this, "参数", "输入set_turbo_depth的参数\n int depth", QLineEdit::Normal, "", &ok);
+        if (ok) {
+            int depth = args.toInt(&ok);
+            if (ok and depth >= 1 and depth <= 4) {
+                turboDepth = depth;
+                if (turboTimer.isActive()) start_turbo();
+            } else {
+                QMessageBox::warning(this, "无效指令", "无效参数depth：" + args);
+            }
+        }
+    } else if (cmdName == "set_ai_depth") {
+        QString args = QInputDialog::getText(this, "参数", "输入set_ai_depth的参数\n int depth", QLineEdit::Normal, "", &ok);
+        if (ok) {
+            int depth = args.toInt(&ok);
+            if (searchRunning) {
+                QMessageBox::warning(this, "无效指令", "AI正在搜索，请稍后再试");
+            } else if (ok and depth >= 1 and depth <= 12) {
+                ai.depth = depth;
+            } else {
+                QMessageBox::warning(this, "无效指令", "无效参数depth：" + args);
+            }
+        }
+    } else if (cmdName == "set_ai_time") {
+        QString args = QInputDialog::getText(this, "参数", "输入set_ai_time的参数\n int milliseconds", QLineEdit::Normal, "", &ok);
+        if (ok) {
+            int ms = args.toInt(&ok);
+            if (ok and ms >= 0) {
+                aiTimeBudget = ms;
+            } else {
+                QMessageBox::warning(this, "无效指令", "无效参数milliseconds：" + args);
+            }
+        }
+    } else if (cmdName == "load_ntuple") {
+        QString args = QInputDialog::getText(this, "参数", "输入load_ntuple的参数\n QString path，留空则恢复默认估值", QLineEdit::Normal, "", &ok);
+        if (ok) {
+            if (searchRunning or turboTimer.isActive()) {
+                QMessageBox::warning(this, "无效指令", "AI正在搜索，请稍后再试");
+            } else if (args.isEmpty()) {
+                ai.evaluator = nullptr;
+                network.reset();
+            } else {
+                std::unique_ptr<NTupleNetwork> loaded(new NTupleNetwork(NTupleNetwork::patterns("4tuple")));
+                if (loaded->load(args.toStdString())) {
+                    network = std::move(loaded);
+                    ai.evaluator = network.get();
+                } else {
+                    QMessageBox::warning(this, "无效指令", "无法读取权重文件：" + args);
+                }
+            }
+        }
+    } else if (cmdName == "goto_step") {
+        if (four_by_four_only()) return;
+        QString args = QInputDialog::getText(this, "参数", "输入goto_step的参数\n int step", QLineEdit::Normal, "", &ok);
+        if (ok) {
+            int step = args.toInt(&ok);
+            if (undoLock) {
+                QMessageBox::warning(this, "无效指令", "撤销已锁定。");
+            } else if (ok and step >= 0) {
+                UndoHistory::NodeId node = history.ancestor(history.current(), step);
+                if (node == UndoHistory::NONE) {
+                    node = history.current();
+                    while (history.depth(node) < step and history.redo()) node = history.current();
+                }
+                history.jump(node);
+                show_history_state();
+            } else {
+                QMessageBox::warning(this, "无效指令", "无效参数step：" + args);
+            }
+        }
+    } else if (cmdName == "branches") {
+        if (four_by_four_only()) return;
+        show_branches();
+    } else if (cmdName == "switch_branch") {
+        if (four_by_four_only()) return;
+        QString args = QInputDialog::getText(this, "参数", "输入switch_branch的参数\n int branch", QLineEdit::Normal, "", &ok);
+        if (ok) {
+            int k = args.toInt(&ok);
+            UndoHistory::NodeId fork = history.branch_point(history.current());
+            std::vector<UndoHistory::NodeId> lines;
+            if (fork != UndoHistory::NONE) lines = history.children(fork);
+            if (undoLock) {
+                QMessageBox::warning(this, "无效指令", "撤销已锁定。");
+            } else if (ok and k >= 1 and k <= (int)lines.size()) {
+                history.jump(history.line_end(lines[k - 1]));
+                show_history_state();
+            } else {
+                QMessageBox::warning(this, "无效指令", "无效参数branch：" + args);
+            }
+        }
     }
     else QMessageBox::warning(this, "无效指令", "无效指令：" + cmdName);
+
+    // Grid boards are not journaled, and a replay's board is not the game
+    // the journal records.
+    if (!grid_mode() and !replayMode) {
+        journal.sync(game);
+        journal.flush();
+    }
+    schedule_autosave();
+}
+
+void MainWindow::start_journal() {
+    QString dir = QCoreApplication::applicationDirPath() + "/replays";
+    QDir().mkpath(dir);
+    QString path = dir + "/" + QDateTime::currentDateTime().toString("yyyyMMdd-HHmmss-zzz") + ".2048replay";
+    if (!journal.open(path.toStdString(), game.random.state)) {
+        statusBar()->showMessage("无法创建回放文件：" + path, 5000);
+    }
 }
 
 void MainWindow::show_update_content() {
@@ -515,20 +602,82 @@ void MainWindow::about_me() {
 }
 
 void MainWindow::undo() {
-    if (undoLock) return;
-    if (undoStack.empty()) return;
-    NumbersStep step = undoStack.back();
-    undoStack.pop_back();
-    for (int i = 0; i < 4; ++i) {
-        for (int j = 0; j < 4; ++j) {
-            spawn_number_without_animation(i, j, step.numbers[i][j]);
-        }
+    if (undoLock or replayMode) return;
+    if (grid_mode()) {
+        if (!step_grid_history(gridUndo, gridRedo)) return;
+    } else {
+        if (!history.undo()) return;
+        show_history_state();
     }
-    score = step.score;
     undoCount++;
     undoCountLabel->setText("撤销次数："+QString::number(undoCount));
-    scoreLabel->setText(QString::number(score));
-    if (undoStack.empty()) undoAction->setEnabled(false);
+}
+
+void MainWindow::redo() {
+    if (undoLock or replayMode) return;
+    if (grid_mode()) {
+        step_grid_history(gridRedo, gridUndo);
+        return;
+    }
+    if (!history.redo()) return;
+    show_history_state();
+}
+
+// Moves the grid game to the last state of `from`, keeping the one it
+// leaves on `to`.
+bool MainWindow::step_grid_history(std::vector<GridState> &from, std::vector<GridState> &to) {
+    if (from.empty()) return false;
+    to.push_back({grid.board, grid.score});
+    grid.board = from.back().board;
+    grid.score = from.back().score;
+    from.pop_back();
+    show_game_state();
+    undoAction->setEnabled(!gridUndo.empty());
+    redoAction->setEnabled(!gridRedo.empty());
+    return true;
+}
+
+void MainWindow::show_history_state() {
+    game.set_wide_board(history.current_state().wide_board());
+    game.score = history.current_state().score;
+    show_game_state();
+    journal.sync(game);
+    journal.flush();
+    schedule_autosave();
+    undoAction->setEnabled(history.can_undo());
+    redoAction->setEnabled(history.can_redo());
+}
+
+// Draws the current board at once, without the move and spawn animations.
+void MainWindow::show_game_state() {
+    gameArea->finish_animation();
+    for (int i = 0; i < cellCount; ++i) {
+        for (int j = 0; j < cellCount; ++j) {
+            gameArea->data[i][j] = board_cell(i, j);
+        }
+    }
+    gameArea->update();
+    scoreLabel->setText(QString::number(game_score()));
+}
+
+// Lists the lines that split at the nearest branch point above the current
+// state, with where each of them ends.
+void MainWindow::show_branches() {
+    UndoHistory::NodeId fork = history.branch_point(history.current());
+    if (fork == UndoHistory::NONE) {
+        QMessageBox::information(this, "分支", "当前局面之前没有分支。");
+        return;
+    }
+    QString text = "第" + QString::number(history.depth(fork)) + "步处有以下分支：<br>";
+    std::vector<UndoHistory::NodeId> lines = history.children(fork);
+    for (size_t k = 0; k < lines.size(); ++k) {
+        UndoHistory::NodeId end = history.line_end(lines[k]);
+        GameState last = history.state(end);
+        bool current = history.ancestor(history.current(), history.depth(lines[k])) == lines[k];
+        text += QString::number(k + 1) + ". 共" + QString::number(history.depth(end)) + "步，分数" + QString::number(last.score) +
+                "，最大方块" + QString::number((qulonglong)1 << wide_max_tile(last.wide_board())) + (current ? "（当前）" : "") + "<br>";
+    }
+    QMessageBox::information(this, "分支", text);
 }
 
 void MainWindow::fill_number(int sr, int sc, int er, int ec, int number) {
@@ -543,55 +692,95 @@ void MainWindow::show_cmd_help() {
     QMessageBox::information(this, "指令帮助", commandHelpText);
 }
 
-void MainWindow::push_to_stack(NumbersStep step) {
-    if (undoStack.size() >= 64) {
-        undoStack.pop_front();
-    }
-    undoStack.push_back(step);
+void MainWindow::push_to_history(GameState before) {
+    // A run_cmd edit since the last move becomes a state of its own, so
+    // undo goes back to the board as it was right before this move.
+    const GameState &last = history.current_state();
+    if (before != last) history.advance(before);
+    history.advance({game.board, game.score, game.high});
     undoAction->setEnabled(true);
+    redoAction->setEnabled(history.can_redo());
+}
+
+// The game as it is on screen. A run_cmd edit since the last move is not
+// in the history yet, and a save needs the history to end at this state.
+SavedGame MainWindow::saved_game() {
+    GameState state{game.board, game.score, game.high};
+    if (history.current_state() != state) {
+        history.advance(state);
+        undoAction->setEnabled(history.can_undo());
+        redoAction->setEnabled(history.can_redo());
+    }
+    SavedGame saved;
+    saved.board = game.board;
+    saved.high = game.high;
+    saved.score = game.score;
+    saved.randomState = game.random.state;
+    saved.undoCount = undoCount;
+    saved.undoLock = undoLock;
+    return saved;
 }
 
 bool MainWindow::write_file(const QString& filepath) {
-    std::ofstream f;
-    f.open(filepath.toLocal8Bit(), std::ios::binary);
-    if (!f.is_open()) return false;
+    if (!write_saved_game(filepath.toLocal8Bit().toStdString(), saved_game(), history)) {
+        QMessageBox::warning(this, "保存失败", "无法写入存档文件：" + filepath);
+        return false;
+    }
     fp = filepath;
-
-    char _undoLock = (char)undoLock;
-    f.write((char*)&score, sizeof(score));
-    f.write((char*)&undoCount, sizeof(undoCount));
-    f.write((char*)numbers, sizeof(numbers));
-    f.write(&_undoLock, sizeof(_undoLock));
-    f.close();
+    replayMode = false;
+    replayScrubber->hide();
 
     statusBar()->showMessage("已保存文件到："+fp, 5000);
     return true;
 }
 
 bool MainWindow::read_file(const QString &filepath) {
-    std::ifstream f;
-    f.open(filepath.toLocal8Bit(), std::ios::binary);
-    if (!f.is_open()) return false;
+    // Everything is checked before the game or the window changes.
+    SavedGame saved;
+    UndoHistory loaded;
+    SaveFormat format = read_saved_game(filepath.toLocal8Bit().toStdString(), saved, loaded);
+    if (format == SaveFormat::Invalid) {
+        QMessageBox::warning(this, "打开失败", "存档文件不存在、已损坏或版本过新：" + filepath);
+        return false;
+    }
     fp = filepath;
+    show_saved_game(saved, loaded, format);
+    schedule_autosave();
+
+    statusBar()->showMessage("已打开文件："+fp, 5000);
 
-    char _undoLock;
-    f.read((char*)&score, sizeof(score));
-    f.read((char*)&undoCount, sizeof(undoCount));
-    f.read((char*)numbers, sizeof(numbers));
-    f.read(&_undoLock, sizeof(_undoLock));
+    return true;
+}
+
+void MainWindow::show_saved_game(const SavedGame &saved, UndoHistory &loaded, SaveFormat format) {
+    if (grid_mode()) resize_board(BOARD_SIZE);
+    replayMode = false;
+    replayScrubber->hide();
+
+    game.clear();
+    game.set_wide_board({saved.board, saved.high});
+    game.score = saved.score;
+    // Legacy saves have no random state; keep ours.
+    if (format == SaveFormat::Current) game.random.state = saved.randomState;
+    undoCount = saved.undoCount;
+
+    set_undo_lock(saved.undoLock);
+    scoreLabel->setText(QString::number(game.score));
+    history = std::move(loaded);
+    undoAction->setEnabled(history.can_undo());
+    redoAction->setEnabled(history.can_redo());
 
-    set_undo_lock((bool)_undoLock);
-    scoreLabel->setText(QString::number(score));
     bool first2048Flag = true;
     gameArea->stop_animation();
     for (int i = 0; i < cellCount; ++i) {
         for (int j = 0; j < cellCount; ++j) {
-            if (numbers[i][j] == 0) {
+            int n = board_cell(i, j);
+            if (n == 0) {
                 gameArea->data[i][j] = 0;
             } else {
-                gameArea->add_spawn_animation(i, j, numbers[i][j]);
+                gameArea->add_spawn_animation(i, j, n);
             }
-            if (numbers[i][j] >= 11) {
+            if (n >= 11) {
                 first2048Flag = false;
             }
         }
@@ -599,12 +788,24 @@ bool MainWindow::read_file(const QString &filepath) {
     gameArea->start_animation();
     first2048 = first2048Flag;
 
-    undoStack.clear();
-    undoAction->setEnabled(false);
+    if (grid_mode()) return;
+    start_journal();
+    journal.sync(game);
+    journal.flush();
+}
 
-    statusBar()->showMessage("已打开文件："+fp, 5000);
+void MainWindow::schedule_autosave() {
+    // Not restarted by later changes, so steady play still saves once per
+    // interval, and a burst of moves costs one snapshot.
+    if (!autosaveTimer.isActive()) autosaveTimer.start();
+}
 
-    return true;
+void MainWindow::autosave() {
+    autosaveTimer.stop();
+    if (!autosaver or replayMode or grid_mode()) return;
+    std::vector<uint8_t> snapshot;
+    encode_saved_game(saved_game(), history, snapshot);
+    autosaver->submit(std::move(snapshot));
 }
 
 void MainWindow::open() {
@@ -613,12 +814,56 @@ void MainWindow::open() {
     read_file(filepath);
 }
 
+void MainWindow::open_replay() {
+    QString filepath = QFileDialog::getOpenFileName(this, "打开回放", QCoreApplication::applicationDirPath() + "/replays",
+                                                    "2048回放(*.2048replay)");
+    if (filepath.isEmpty()) return;
+    if (!replay.open(filepath.toStdString())) {
+        QMessageBox::warning(this, "打开失败", "无法读取回放文件：" + filepath);
+        return;
+    }
+    set_autoplay(false);
+    set_turbo(false);
+    // The replay takes over the board; save the game it replaces first.
+    if (autosaveTimer.isActive()) autosave();
+    if (grid_mode()) resize_board(BOARD_SIZE);
+    replayMode = true;
+    replayScrubber->set_total_moves((int)replay.total_moves());
+    replayScrubber->show();
+    replay_seek(0);
+    statusBar()->showMessage("已打开回放：" + filepath + "，拖动滑块查看任意一步，走一步即从当前局面继续游戏。", 5000);
+}
+
+void MainWindow::replay_seek(int move) {
+    if (!replayMode) return;
+    if (!replay.seek(game, (uint64_t)move)) {
+        statusBar()->showMessage("回放文件已损坏，只能显示到第" + QString::number(replay.move_count()) + "步。", 5000);
+    }
+    show_game_state();
+}
+
+// Leaves the replay and carries on playing from the state on screen.
+void MainWindow::close_replay() {
+    if (!replayMode) return;
+    replayMode = false;
+    replayScrubber->hide();
+    history.reset({game.board, game.score, game.high});
+    undoAction->setEnabled(false);
+    redoAction->setEnabled(false);
+    start_journal();
+    journal.sync(game);
+    journal.flush();
+    schedule_autosave();
+}
+
 void MainWindow::save() {
+    if (four_by_four_only()) return;
     if (fp.isEmpty()) save_as();
     else write_file(fp);
 }
 
 void MainWindow::save_as() {
+    if (four_by_four_only()) return;
     QString filepath = QFileDialog::getSaveFileName(this, "另存为", "", "2048游戏存档(*.2048game)");
     if (!filepath.isEmpty()) write_file(filepath);
 }
@@ -634,6 +879,146 @@ void MainWindow::set_undo_lock(bool l) {
     }
 }
 
+static QString direction_text(Direction d) {
+    switch (d) {
+        case Direction::Up:    return "上";
+        case Direction::Down:  return "下";
+        case Direction::Left:  return "左";
+        case Direction::Right: return "右";
+    }
+    return "";
+}
+
+void MainWindow::hint() {
+    if (four_by_four_only()) return;
+    start_search(false);
+}
+
+void MainWindow::set_autoplay(bool on) {
+    if (on and four_by_four_only()) on = false;
+    if (on) {
+        set_turbo(false);
+        autoplayTimer.start();
+    } else {
+        autoplayTimer.stop();
+    }
+    if (autoplayAction->isChecked() != on) autoplayAction->setChecked(on);
+}
+
+void MainWindow::autoplayTimer_timeout() {
+    start_search(true);
+}
+
+void MainWindow::set_turbo(bool on) {
+    if (on and four_by_four_only()) on = false;
+    if (on) {
+        if (replayMode) close_replay();
+        set_autoplay(false);
+        start_turbo();
+        turboTimer.start();
+        turboLabel->setText("极速：0步/秒");
+        turboLabel->show();
+    } else {
+        turboTimer.stop();
+        turbo.stop();
+        turboLabel->hide();
+    }
+    if (turboAction->isChecked() != on) turboAction->setChecked(on);
+}
+
+void MainWindow::start_turbo() {
+    turboGame = game;
+    turbo.start(turboGame, turboDepth, ai.evaluator);
+    turboRateClock.start();
+    turboRateMoves = 0;
+}
+
+// Replays the moves the turbo player made since the last frame, then draws
+// the board they lead to once.
+void MainWindow::turboTimer_timeout() {
+    // Keys, undo and commands keep working during turbo play. After one of
+    // them the queued moves are for another board, so play restarts from the
+    // board on screen.
+    if (game.wide_board() != turboGame.wide_board() || game.score != turboGame.score ||
+        game.random.state != turboGame.random.state) {
+        start_turbo();
+        return;
+    }
+
+    turboMoves.clear();
+    bool more = turbo.take_moves(turboMoves);
+    for (Direction d : turboMoves) {
+        GameState step{game.board, game.score, game.high};
+        game.move(d);
+        journal.record_move(d, game);
+        push_to_history(step);
+    }
+    turboGame = game;
+    turboRateMoves += turboMoves.size();
+    if (!turboMoves.empty()) {
+        journal.flush();
+        schedule_autosave();
+        show_game_state();
+        if (first2048 and game.max_tile() >= 11) {
+            first2048 = false;
+            gameArea->play_win_animation();
+        }
+    }
+
+    qint64 elapsed = turboRateClock.elapsed();
+    if (elapsed >= 500) {
+        turboLabel->setText("极速：" + QString::number(qRound64(turboRateMoves * 1000.0 / elapsed)) +
+                            "步/秒，分数：" + QString::number(game.score));
+        turboRateClock.restart();
+        turboRateMoves = 0;
+    }
+    if (!more) {
+        set_turbo(false);
+        statusBar()->showMessage("无法移动，极速自动游戏已停止。", 5000);
+    }
+}
+
+// Searches on a background thread so key presses and animations never wait
+// for the AI. The result is posted back to the GUI thread.
+void MainWindow::start_search(bool autoplayMove) {
+    if (searchRunning) return;
+    if (searchThread.joinable()) searchThread.join();
+    searchRunning = true;
+
+    WideBoard board = game.wide_board();
+    int budget = aiTimeBudget;
+    searchThread = std::thread([this, board, budget, autoplayMove] {
+        SearchResult result = budget > 0 ? ai.search_timed(board, budget) : ai.search(board);
+        QMetaObject::invokeMethod(this, [this, board, result, autoplayMove] {
+            finish_search(board, result, autoplayMove);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void MainWindow::finish_search(WideBoard board, const SearchResult &result, bool autoplayMove) {
+    searchRunning = false;
+    // The board changed while searching, so the move is for a stale position.
+    if (board != game.wide_board()) return;
+
+    if (!result.found) {
+        if (autoplayMove) {
+            set_autoplay(false);
+            statusBar()->showMessage("无法移动，自动游戏已停止。", 5000);
+        } else {
+            statusBar()->showMessage("无法移动。", 5000);
+        }
+        return;
+    }
+    if (autoplayMove) {
+        if (autoplayTimer.isActive()) play_move(result.move);
+        return;
+    }
+    statusBar()->showMessage("提示：" + direction_text(result.move) +
+                             "（深度" + QString::number(result.depth) +
+                             "，节点" + QString::number(result.nodes) +
+                             "，" + QString::number(result.elapsedMs, 'f', 1) + "毫秒）", 5000);
+}
+
 void MainWindow::init_settings() {
     load_settings(QCoreApplication::applicationDirPath() + "/settings.ini");
 
@@ -684,3 +1069,43 @@ void MainWindow::loadSettingsAction_triggered() {
     QString filepath = QFileDialog::getOpenFileName(this, "打开", "./", "配置文件(*.ini)");
     if (!filepath.isEmpty()) load_settings(filepath);
 }
+
+void MainWindow::boardSizeAction_triggered(QAction *action) {
+    set_board_size(action->data().toInt());
+}
+
+// Starts a new game on a size x size board.
+void MainWindow::set_board_size(int size) {
+    if (size < MIN_BOARD_SIZE or size > MAX_BOARD_SIZE or size == cellCount) return;
+    set_autoplay(false);
+    set_turbo(false);
+    // The 4x4 game is left behind; save it first.
+    if (autosaveTimer.isActive()) autosave();
+    resize_board(size);
+    new_game();
+    if (grid_mode()) statusBar()->showMessage(FOUR_BY_FOUR_ONLY_TEXT, 5000);
+}
+
+// Switches the board and the window to size x size, leaving the game to
+// the caller.
+void MainWindow::resize_board(int size) {
+    cellCount = size;
+    if (grid_mode()) grid.resize(size);
+    gameArea->set_cell_count(size);
+    setFixedWidth(gameArea->frameSize + 20);
+    adjustSize();
+
+    for (QAction *action : {hintAction, autoplayAction, turboAction, saveAction, saveAsAction}) {
+        action->setEnabled(!grid_mode());
+    }
+    for (QAction *action : boardSizeGroup->actions()) {
+        if (action->data().toInt() == size) action->setChecked(true);
+    }
+}
+
+// Tells the user and returns true when the board is not 4x4.
+bool MainWindow::four_by_four_only() {
+    if (!grid_mode()) return false;
+    statusBar()->showMessage(FOUR_BY_FOUR_ONLY_TEXT, 5000);
+    return true;
+}
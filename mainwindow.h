@@ -2,18 +2,25 @@
 #define MAINWINDOW_H
 
 #include <QMainWindow>
-#include <random>
 #include <QPushButton>
 #include <QLabel>
 #include <QAction>
-#include <deque>
+#include <QActionGroup>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <thread>
 
 #include "GameArea.h"
-
-struct NumbersStep{
-    int numbers[4][4];
-    int score;
-};
+#include "ReplayScrubber.h"
+#include "GameEngine.h"
+#include "GridEngine.h"
+#include "GameAI.h"
+#include "NTupleNetwork.h"
+#include "UndoHistory.h"
+#include "ReplayJournal.h"
+#include "SaveFile.h"
+#include "AutoSaver.h"
+#include "TurboPlayer.h"
 
 class MainWindow : public QMainWindow
 {
@@ -30,18 +37,25 @@ public:
     QLabel *nameLabel;
     QLabel *scoreLabel;
     QLabel *undoCountLabel;
+    QLabel *turboLabel;
     QAction *newGameAction;
     QAction *openAction;
+    QAction *openReplayAction;
     QAction *saveAction;
     QAction *saveAsAction;
     QAction *undoLockAction;
     QAction *undoAction;
+    QAction *redoAction;
+    QAction *hintAction;
+    QAction *autoplayAction;
+    QAction *turboAction;
     QAction *cmdAction;
     QAction *helpCmdAction;
     QAction *loadSettingsAction;
     QAction *updateContentAction;
     QAction *aboutQtAction;
     QAction *aboutMeAction;
+    QActionGroup *boardSizeGroup;
 
 public slots:
     void up();
@@ -53,16 +67,29 @@ public slots:
     void run_cmd();
     void show_cmd_help();
     void undo();
+    void redo();
     void show_update_content();
     void about_qt();
     void about_me();
 
     void open();
+    void open_replay();
+    void replay_seek(int move);
+    void close_replay();
     void save();
     void save_as();
     void set_undo_lock(bool l);
 
+    void hint();
+    void set_autoplay(bool on);
+    void autoplayTimer_timeout();
+    void set_turbo(bool on);
+    void turboTimer_timeout();
+    void autosave();
+
     void loadSettingsAction_triggered();
+    void set_board_size(int size);
+    void boardSizeAction_triggered(QAction *action);
 
 private:
     void init_ui();
@@ -70,24 +97,62 @@ private:
     void load_settings(const QString& fp);
 
     void random_spawn_number();
-    bool try_span(int fr, int fc, int tr, int tc);
+    void play_move(Direction d);
+    void show_move(const MoveTrace &trace);
+    void start_search(bool autoplayMove);
+    void finish_search(WideBoard board, const SearchResult &result, bool autoplayMove);
 
     void output();
     void spawn_number_without_animation(int row, int column, int number);
-    void move_number(int fr, int fc, int tr, int tc);
     void fill_number(int sr, int sc, int er, int ec, int number);
     bool write_file(const QString& filepath);
     bool read_file(const QString& filepath);
+    SavedGame saved_game();
+    void show_saved_game(const SavedGame &saved, UndoHistory &loaded, SaveFormat format);
 
     int cellCount = 4;
-    int numbers[4][4];
-    bool isSpan[4][4];
-    int score = 0;
+    GameEngine game;
+
+    // Boards other than 4x4 are played by grid instead of game. The AI,
+    // replays and saves work on 4x4 boards only, so these boards get a
+    // plain undo stack and are neither journaled nor autosaved.
+    struct GridState {
+        GridBoard board;
+        int64_t score;
+    };
+    GridGame grid;
+    std::vector<GridState> gridUndo, gridRedo;
+    bool grid_mode() const { return cellCount != BOARD_SIZE; }
+    bool four_by_four_only();
+    int board_cell(int row, int column) const { return grid_mode() ? grid.get(row, column) : game.get(row, column); }
+    int64_t &game_score() { return grid_mode() ? grid.score : game.score; }
+    void resize_board(int size);
+    void play_grid_move(Direction d);
+    bool step_grid_history(std::vector<GridState> &from, std::vector<GridState> &to);
+
     int undoCount = 0;
     bool undoLock = false;
     bool first2048 = true;
     QString fp;
-    std::default_random_engine randomEngine;
+
+    GameAI ai;
+    int aiTimeBudget = 50;
+    std::unique_ptr<NTupleNetwork> network;
+    QTimer autoplayTimer;
+    std::thread searchThread;
+    bool searchRunning = false;
+
+    // Turbo autoplay: the turbo player searches on its own thread and
+    // turboTimer replays the moves it made once per frame, without
+    // animations. turboGame is where the turbo player's moves start from.
+    TurboPlayer turbo;
+    QTimer turboTimer;
+    int turboDepth = 2;
+    std::vector<Direction> turboMoves;
+    GameEngine turboGame;
+    QElapsedTimer turboRateClock;
+    uint64_t turboRateMoves = 0;
+    void start_turbo();
 
     QString commandHelpText;
     QString commandLoveText;
@@ -95,7 +160,26 @@ private:
     QString updateDateText;
     QString updateContentText;
 
-    std::deque<NumbersStep> undoStack;
-    void push_to_stack(NumbersStep step);
+    UndoHistory history;
+    void push_to_history(GameState before);
+    void show_history_state();
+    void show_game_state();
+    void show_branches();
+
+    // Every game is journaled to replays/ next to the executable.
+    ReplayWriter journal;
+    void start_journal();
+
+    // Changes are saved to autosave.2048game next to the executable at
+    // most once per autosaveTimer interval, on the autosaver's thread; the
+    // next start carries on from it.
+    std::unique_ptr<AutoSaver> autosaver;
+    QTimer autosaveTimer;
+    void schedule_autosave();
+
+    // Viewing a replay: the scrubber seeks and shows states directly.
+    ReplayScrubber *replayScrubber;
+    ReplayReader replay;
+    bool replayMode = false;
 };
 #endif // MAINWINDOW_H